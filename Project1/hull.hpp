@@ -0,0 +1,203 @@
+#ifndef VE281P1_HULL_HPP
+#define VE281P1_HULL_HPP
+#include "predicate.hpp"
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+/**
+ * A 2D point
+ * @tparam T coordinate type (int32, int64 or double)
+ */
+template <typename T>
+class point{
+private:
+    T x;
+    T y;
+public:
+    typedef T coord_type;
+    point() : x(), y() {}
+    point(T x, T y);
+    void setX(T x);
+    void setY(T y);
+    T X() const;
+    T Y() const;
+    bool isEqual(const point &p1) const;
+    double D() const;
+    void print() const;
+    template <typename Orient = predicate::orientation<T>>
+    static int ccw(const point &p1, const point &p2, const point &p3, Orient orient = Orient());
+    static bool comp_by_coordinate(const point &p1, const point &p2);
+    bool operator==(const point &p1) const;
+};
+
+template <typename T>
+point<T>::point(T x, T y){this->x = x; this->y = y;}
+
+template <typename T>
+void point<T>::setX(T x){this->x = x;}
+
+template <typename T>
+void point<T>::setY(T y){this->y = y;}
+
+template <typename T>
+T point<T>::X() const {return this->x;}
+
+template <typename T>
+T point<T>::Y() const {return this->y;}
+
+template <typename T>
+bool point<T>::isEqual(const point &p1) const {return this->x==p1.x && this->y==p1.y;}
+
+template <typename T>
+double point<T>::D() const {return (double)this->x * (double)this->x + (double)this->y * (double)this->y;}
+
+template <typename T>
+void point<T>::print() const {std::cout << this->x << " " << this->y << "\n";}
+
+/**
+ * @return 1 if p1->p2->p3 is counterclockwise, -1 if clockwise, 0 if collinear
+ */
+template <typename T>
+template <typename Orient>
+int point<T>::ccw(const point &p1, const point &p2, const point &p3, Orient orient){
+    return orient(p1.x, p1.y, p2.x, p2.y, p3.x, p3.y);
+}
+
+template <typename T>
+bool point<T>::operator==(const point &p1) const {return (this->x==p1.x)&&(this->y==p1.y);}
+
+template <typename T>
+bool point<T>::comp_by_coordinate(const point &p1, const point &p2){
+    return (p1.y == p2.y) ? (p1.x < p2.x) : (p1.y < p2.y);
+}
+
+template <typename T>
+void print_point_vec(const std::vector<point<T>> &vp){
+    for (auto &i: vp){
+        i.print();
+    }
+}
+
+/**
+ * Sort stage of the Graham scan
+ * Move the lowest (then leftmost) point p0 out of vp, drop its duplicates, sort the rest by
+ * decreasing polar angle around p0 and keep only the farthest point of each ray from p0
+ * Time Complexity: O(n log n)
+ * @throw std::domain_error if vp is empty, as there is no p0
+ * @return p0
+ */
+template <typename T, typename Orient = predicate::orientation<T>>
+point<T> graham_sort(std::vector<point<T>> &vp, Orient orient = Orient()){
+    if (vp.empty()) throw std::domain_error("Graham sort needs at least one point");
+    auto lowest = std::min_element(vp.begin(), vp.end(), point<T>::comp_by_coordinate);
+    std::iter_swap(vp.begin(), lowest);
+    point<T> p0 = vp[0];
+    vp.erase(std::remove(vp.begin(), vp.end(), p0), vp.end());
+    // Every other point lies in the half plane above p0, so the polar angles are in [0, pi)
+    // Sort by decreasing angle, nearer points first on the same ray
+    std::sort(vp.begin(), vp.end(), [&](const point<T> &p1, const point<T> &p2){
+        int ccw = point<T>::ccw(p0, p1, p2, orient);
+        return (ccw == 0) ? point<T>::comp_by_coordinate(p1, p2) : (ccw < 0);
+    });
+    size_t N = 0;
+    for (size_t i = 0; i < vp.size(); i++){
+        if (i + 1 < vp.size() && point<T>::ccw(p0, vp[i], vp[i + 1], orient) == 0){
+            continue;
+        }
+        vp[N++] = vp[i];
+    }
+    vp.resize(N);
+    return p0;
+}
+
+/**
+ * Scan stage of the Graham scan, on the output of graham_sort
+ * Time Complexity: O(n)
+ * @return the vertices of the convex hull
+ */
+template <typename T, typename Orient = predicate::orientation<T>>
+std::vector<point<T>> graham_stack(const point<T> &p0, const std::vector<point<T>> &vp, Orient orient = Orient()){
+    // s is used as a stack, its top is s.back()
+    std::vector<point<T>> s;
+    s.reserve(vp.size() + 1);
+    for (auto &p: vp){
+        while (s.size() > 1 && point<T>::ccw(s[s.size() - 2], s.back(), p, orient) > 0){
+            s.pop_back();
+        }
+        s.push_back(p);
+    }
+    s.push_back(p0);
+    std::reverse(s.begin(), s.end());
+    return s;
+}
+
+/**
+ * Graham scan
+ * The hull starts at the lowest (then leftmost) point and is listed counterclockwise
+ * Collinear points on the hull edges are kept, duplicates of the start point are dropped
+ * Time Complexity: O(n log n)
+ * @tparam Orient orientation predicate, see predicate.hpp
+ * @param vp the input points, reordered in place
+ * @return the vertices of the convex hull
+ */
+template <typename T, typename Orient = predicate::orientation<T>>
+std::vector<point<T>> graham_scan(std::vector<point<T>> &vp, Orient orient = Orient()){
+    if (vp.empty()) return std::vector<point<T>>();
+    point<T> p0 = graham_sort(vp, orient);
+    return graham_stack(p0, vp, orient);
+}
+
+/**
+ * Sort stage of Andrew's monotone chain: sort by coordinate and drop duplicates
+ * Time Complexity: O(n log n)
+ */
+template <typename T>
+void monotone_chain_sort(std::vector<point<T>> &vp){
+    std::sort(vp.begin(), vp.end(), point<T>::comp_by_coordinate);
+    vp.erase(std::unique(vp.begin(), vp.end()), vp.end());
+}
+
+/**
+ * Scan stage of Andrew's monotone chain, on the output of monotone_chain_sort
+ * Builds the right chain bottom-up and the left chain top-down
+ * Time Complexity: O(n)
+ * @return the vertices of the convex hull, in the same order as graham_scan
+ *         but without collinear boundary points
+ */
+template <typename T, typename Orient = predicate::orientation<T>>
+std::vector<point<T>> monotone_chain_scan(const std::vector<point<T>> &vp, Orient orient = Orient()){
+    if (vp.size() < 3) return vp;
+    std::vector<point<T>> s;
+    s.reserve(vp.size() + 1);
+    for (auto &p: vp){
+        while (s.size() > 1 && point<T>::ccw(s[s.size() - 2], s.back(), p, orient) <= 0){
+            s.pop_back();
+        }
+        s.push_back(p);
+    }
+    size_t right = s.size();
+    for (size_t i = vp.size() - 1; i-- > 0;){
+        while (s.size() > right && point<T>::ccw(s[s.size() - 2], s.back(), vp[i], orient) <= 0){
+            s.pop_back();
+        }
+        s.push_back(vp[i]);
+    }
+    s.pop_back();
+    return s;
+}
+
+/**
+ * Andrew's monotone chain, an alternative to graham_scan without polar angles
+ * Time Complexity: O(n log n)
+ * @param vp the input points, reordered in place
+ * @return the vertices of the convex hull
+ */
+template <typename T, typename Orient = predicate::orientation<T>>
+std::vector<point<T>> monotone_chain(std::vector<point<T>> &vp, Orient orient = Orient()){
+    monotone_chain_sort(vp);
+    return monotone_chain_scan(vp, orient);
+}
+
+#endif //VE281P1_HULL_HPP
@@ -0,0 +1,191 @@
+#include "hull.hpp"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+using namespace std;
+
+// Usage: ./hull_performance [max_exponent=6] [seed]
+// Sizes run from 10^3 to 10^max_exponent, 10^8 needs about 8 GB of memory
+// Output (CSV): engine,distribution,n,parse,sort,scan,total,hull_size (seconds)
+
+static const double R = 1e6;
+
+typedef vector<point<double>> (*generator)(size_t n, mt19937_64 &gen);
+
+vector<point<double>> gen_square(size_t n, mt19937_64 &gen)
+{
+    uniform_real_distribution<double> u(-R, R);
+    vector<point<double>> vp(n);
+    for (auto &p : vp)
+    {
+        p = point<double>(u(gen), u(gen));
+    }
+    return vp;
+}
+
+vector<point<double>> gen_disk(size_t n, mt19937_64 &gen)
+{
+    uniform_real_distribution<double> u(0, 1);
+    vector<point<double>> vp(n);
+    for (auto &p : vp)
+    {
+        double r = R * sqrt(u(gen)), theta = 2 * M_PI * u(gen);
+        p = point<double>(r * cos(theta), r * sin(theta));
+    }
+    return vp;
+}
+
+// Every point is a hull vertex (up to rounding)
+vector<point<double>> gen_circle(size_t n, mt19937_64 &gen)
+{
+    uniform_real_distribution<double> u(0, 2 * M_PI);
+    vector<point<double>> vp(n);
+    for (auto &p : vp)
+    {
+        double theta = u(gen);
+        p = point<double>(R * cos(theta), R * sin(theta));
+    }
+    return vp;
+}
+
+vector<point<double>> gen_gaussian(size_t n, mt19937_64 &gen)
+{
+    normal_distribution<double> d(0, R / 4);
+    vector<point<double>> vp(n);
+    for (auto &p : vp)
+    {
+        p = point<double>(d(gen), d(gen));
+    }
+    return vp;
+}
+
+// Integer points on the four sides of a square: exactly collinear runs on every hull edge
+vector<point<double>> gen_collinear(size_t n, mt19937_64 &gen)
+{
+    uniform_int_distribution<long> u(-(long)R, (long)R);
+    uniform_int_distribution<int> side(0, 3);
+    vector<point<double>> vp(n);
+    for (auto &p : vp)
+    {
+        double t = (double)u(gen);
+        switch (side(gen))
+        {
+        case 0: p = point<double>(t, -R); break;
+        case 1: p = point<double>(R, t); break;
+        case 2: p = point<double>(t, R); break;
+        default: p = point<double>(-R, t); break;
+        }
+    }
+    return vp;
+}
+
+// n draws from 100 distinct points
+vector<point<double>> gen_duplicates(size_t n, mt19937_64 &gen)
+{
+    vector<point<double>> pool = gen_square(100, gen);
+    uniform_int_distribution<size_t> u(0, pool.size() - 1);
+    vector<point<double>> vp(n);
+    for (auto &p : vp)
+    {
+        p = pool[u(gen)];
+    }
+    return vp;
+}
+
+string to_text(const vector<point<double>> &vp)
+{
+    string text = to_string(vp.size()) + "\n";
+    char buf[64];
+    for (auto &p : vp)
+    {
+        snprintf(buf, sizeof(buf), "%.17g %.17g\n", p.X(), p.Y());
+        text += buf;
+    }
+    return text;
+}
+
+vector<point<double>> parse(const string &text)
+{
+    const char *s = text.c_str();
+    char *end;
+    size_t n = strtoul(s, &end, 10);
+    vector<point<double>> vp;
+    vp.reserve(n);
+    for (size_t i = 0; i < n; i++)
+    {
+        double x = strtod(end, &end);
+        double y = strtod(end, &end);
+        vp.push_back(point<double>(x, y));
+    }
+    return vp;
+}
+
+double seconds_since(chrono::steady_clock::time_point &start)
+{
+    auto now = chrono::steady_clock::now();
+    chrono::duration<double> elapsed = now - start;
+    start = now;
+    return elapsed.count();
+}
+
+void run(const string &engine, const string &distribution, const string &text)
+{
+    auto start = chrono::steady_clock::now();
+    vector<point<double>> vp = parse(text);
+    size_t n = vp.size();
+    double parse_time = seconds_since(start);
+    vector<point<double>> hull;
+    double sort_time, scan_time;
+    if (engine == "graham_scan")
+    {
+        point<double> p0 = graham_sort(vp);
+        sort_time = seconds_since(start);
+        hull = graham_stack(p0, vp);
+        scan_time = seconds_since(start);
+    }
+    else
+    {
+        monotone_chain_sort(vp);
+        sort_time = seconds_since(start);
+        hull = monotone_chain_scan(vp);
+        scan_time = seconds_since(start);
+    }
+    printf("%s,%s,%zu,%.6f,%.6f,%.6f,%.6f,%zu\n", engine.c_str(), distribution.c_str(), n,
+           parse_time, sort_time, scan_time, parse_time + sort_time + scan_time, hull.size());
+    fflush(stdout);
+}
+
+int main(int argc, char *argv[])
+{
+    int max_exponent = argc > 1 ? atoi(argv[1]) : 6;
+    unsigned long seed = argc > 2 ? strtoul(argv[2], nullptr, 10) : 281;
+    const pair<string, generator> distributions[] = {
+        {"uniform_square", gen_square},
+        {"uniform_disk", gen_disk},
+        {"circle", gen_circle},
+        {"gaussian", gen_gaussian},
+        {"collinear", gen_collinear},
+        {"duplicates", gen_duplicates},
+    };
+    const string engines[] = {"graham_scan", "monotone_chain"};
+    printf("engine,distribution,n,parse,sort,scan,total,hull_size\n");
+    for (int e = 3; e <= max_exponent; e++)
+    {
+        size_t n = (size_t)pow(10, e);
+        for (auto &d : distributions)
+        {
+            mt19937_64 gen(seed);
+            string text = to_text(d.second(n, gen));
+            for (auto &engine : engines)
+            {
+                run(engine, d.first, text);
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,343 @@
+#ifndef VE281P1_HULL_QUERY_HPP
+#define VE281P1_HULL_QUERY_HPP
+#include "hull.hpp"
+#include <array>
+#include <cmath>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/**
+ * Queries on a convex polygon
+ * Built from the output of graham_scan: vertices counterclockwise, starting at the lowest
+ * (then leftmost) point. Collinear boundary points are dropped, so the stored polygon is
+ * strictly convex and its edge directions are sorted by angle in [0, 2pi).
+ * Point queries are exact (they only use the predicates of Orient) and take O(log h);
+ * the rotating calipers metrics are evaluated in double and take O(h).
+ * h is the number of hull vertices
+ * @tparam T coordinate type
+ * @tparam Orient orientation predicate, see predicate.hpp
+ */
+template <typename T, typename Orient = predicate::orientation<T>>
+class hull_query{
+public:
+    struct diameter_result{
+        size_t i;
+        size_t j;
+        double distance;
+    };
+
+    struct width_result{
+        size_t edge;    // the supporting edge is v[edge] -> v[edge + 1]
+        size_t vertex;  // the vertex touching the opposite supporting line
+        double width;
+    };
+
+    struct rect_result{
+        std::array<point<double>, 4> corners;  // counterclockwise
+        double area;
+    };
+
+private:
+    std::vector<point<T>> v;
+    Orient orient;
+
+    size_t next(size_t i) const {return i + 1 == v.size() ? 0 : i + 1;}
+
+    int ccw(const point<T> &a, const point<T> &b, const point<T> &c) const{
+        return point<T>::ccw(a, b, c, orient);
+    }
+
+    /**
+     * Largest i in [1, h - 2] with sgn * orient(v0, v[i], q) >= 0
+     * Time Complexity: O(log h)
+     */
+    size_t sector(const point<T> &q, int sgn) const{
+        size_t lo = 1, hi = v.size() - 2;
+        while (lo < hi){
+            size_t mid = (lo + hi + 1) / 2;
+            if (sgn * ccw(v[0], v[mid], q) >= 0) lo = mid;
+            else hi = mid - 1;
+        }
+        return lo;
+    }
+
+    bool visible(size_t i, const point<T> &q) const{
+        return ccw(v[i], v[next(i)], q) < 0;
+    }
+
+    /**
+     * Smallest d in [1, len] such that pred((from + d) % h), pred must be false..true
+     * Time Complexity: O(log h)
+     */
+    template <typename Pred>
+    size_t first_true(size_t from, size_t len, Pred pred) const{
+        size_t lo = 1, hi = len;
+        while (lo < hi){
+            size_t mid = (lo + hi) / 2;
+            if (pred((from + mid) % v.size())) hi = mid;
+            else lo = mid + 1;
+        }
+        return (from + lo) % v.size();
+    }
+
+    /**
+     * Whether the direction of edge i comes strictly before the direction (-dy, dx) in [0, 2pi)
+     */
+    bool edge_before(size_t i, T dx, T dy) const{
+        const point<T> &a = v[i], &b = v[next(i)];
+        int halfEdge = (b.Y() > a.Y() || (b.Y() == a.Y() && b.X() > a.X())) ? 0 : 1;
+        int halfDir = (dx > 0 || (dx == 0 && dy < 0)) ? 0 : 1;
+        if (halfEdge != halfDir) return halfEdge < halfDir;
+        return orient.dot(a.X(), a.Y(), b.X(), b.Y(), dx, dy) > 0;
+    }
+
+    static double dist(const point<T> &a, const point<T> &b){
+        return std::hypot((double)b.X() - (double)a.X(), (double)b.Y() - (double)a.Y());
+    }
+
+    // Twice the area of triangle a, b, c in double, used by the calipers only
+    static double area2(const point<T> &a, const point<T> &b, const point<T> &c){
+        return ((double)b.X() - (double)a.X()) * ((double)c.Y() - (double)a.Y()) -
+               ((double)b.Y() - (double)a.Y()) * ((double)c.X() - (double)a.X());
+    }
+
+    template <typename Fn>
+    static void parallel_for(size_t n, unsigned threads, Fn fn){
+        if (threads == 0) threads = 1;
+        size_t chunk = (n + threads - 1) / threads;
+        if (threads == 1 || chunk < 1024){
+            fn((size_t)0, n);
+            return;
+        }
+        std::vector<std::thread> workers;
+        for (size_t first = 0; first < n; first += chunk){
+            workers.emplace_back(fn, first, std::min(n, first + chunk));
+        }
+        for (auto &w: workers) w.join();
+    }
+
+public:
+    /**
+     * Time Complexity: O(h)
+     * @param hull output of graham_scan
+     */
+    explicit hull_query(const std::vector<point<T>> &hull, Orient orient = Orient()) : orient(orient){
+        size_t h = hull.size();
+        if (h == 0) return;
+        size_t start = 0;
+        for (size_t i = 1; i < h; i++){
+            if (point<T>::comp_by_coordinate(hull[i], hull[start])) start = i;
+        }
+        for (size_t k = 0; k < h; k++){
+            size_t i = (start + k) % h;
+            const point<T> &prev = hull[(i + h - 1) % h], &next = hull[(i + 1) % h];
+            if (k == 0 || h < 3 || ccw(prev, hull[i], next) != 0) v.push_back(hull[i]);
+        }
+        if (v.size() == 2 && v[0] == v[1]) v.pop_back();
+    }
+
+    size_t size() const {return v.size();}
+
+    const point<T> &vertex(size_t i) const {return v[i];}
+
+    const std::vector<point<T>> &vertices() const {return v;}
+
+    /**
+     * Point in convex polygon by binary search over the fan from v[0]
+     * Points on the boundary are inside
+     * Time Complexity: O(log h)
+     */
+    bool contains(const point<T> &q) const{
+        size_t h = v.size();
+        if (h == 0) return false;
+        if (h == 1) return v[0] == q;
+        if (h == 2){
+            return ccw(v[0], v[1], q) == 0 &&
+                   std::min(v[0].X(), v[1].X()) <= q.X() && q.X() <= std::max(v[0].X(), v[1].X()) &&
+                   std::min(v[0].Y(), v[1].Y()) <= q.Y() && q.Y() <= std::max(v[0].Y(), v[1].Y());
+        }
+        if (ccw(v[0], v[1], q) < 0 || ccw(v[0], v[h - 1], q) > 0) return false;
+        size_t i = sector(q, 1);
+        return ccw(v[i], v[i + 1], q) >= 0;
+    }
+
+    /**
+     * Tangents from an external point
+     * The hull edges visible from q are exactly those from first to second, counterclockwise
+     * Time Complexity: O(log h)
+     * @throw std::domain_error if q is inside or on the hull
+     * @return indices of the two tangent vertices
+     */
+    std::pair<size_t, size_t> tangents(const point<T> &q) const{
+        size_t h = v.size();
+        if (h == 0 || contains(q)) throw std::domain_error("Tangents need a point outside the hull");
+        if (h == 1) return {0, 0};
+        if (h == 2){
+            int o = ccw(v[0], v[1], q);
+            if (o < 0) return {0, 1};
+            if (o > 0) return {1, 0};
+            // collinear: v[0] < v[1] in coordinate order, so q lies beyond one of them
+            size_t near = point<T>::comp_by_coordinate(v[1], q) ? 1 : 0;
+            return {near, near};
+        }
+        // k: an edge visible from q, m: an edge which is not
+        size_t k, m;
+        int first = ccw(v[0], v[1], q), last = ccw(v[0], v[h - 1], q);
+        if (first >= 0 && last <= 0){
+            k = sector(q, 1);
+            m = 0;
+        }
+        else if (first >= 0){
+            k = h - 1;
+            m = 0;
+        }
+        else if (last <= 0){
+            k = 0;
+            m = h - 1;
+        }
+        else{
+            // both edges at v[0] are visible, the ray from q through v[0] leaves the hull through m
+            k = 0;
+            m = sector(q, -1);
+        }
+        auto vis = [&](size_t i){return visible(i, q);};
+        auto hidden = [&](size_t i){return !visible(i, q);};
+        size_t s = first_true(m, (k + h - m) % h, vis);
+        size_t t = first_true(k, (m + h - k) % h, hidden);
+        return {s, t};
+    }
+
+    /**
+     * Extreme vertex in direction (dx, dy), by binary search over the sorted edge directions
+     * Ties (an edge perpendicular to the direction) return the earlier vertex
+     * Time Complexity: O(log h)
+     * @throw std::domain_error if the hull is empty or the direction is zero
+     * @return index of the vertex maximizing dx * x + dy * y
+     */
+    size_t extreme(T dx, T dy) const{
+        if (v.empty() || (dx == 0 && dy == 0)) throw std::domain_error("Invalid extreme point query");
+        size_t lo = 0, hi = v.size();
+        while (lo < hi){
+            size_t mid = (lo + hi) / 2;
+            if (edge_before(mid, dx, dy)) lo = mid + 1;
+            else hi = mid;
+        }
+        return lo == v.size() ? 0 : lo;
+    }
+
+    /**
+     * Farthest pair of vertices by rotating calipers
+     * Time Complexity: O(h)
+     */
+    diameter_result diameter() const{
+        size_t h = v.size();
+        if (h < 2) return {0, 0, 0};
+        if (h == 2) return {0, 1, dist(v[0], v[1])};
+        diameter_result best{0, 0, 0};
+        size_t j = 1;
+        for (size_t i = 0; i < h; i++){
+            size_t i1 = next(i);
+            while (area2(v[i], v[i1], v[next(j)]) > area2(v[i], v[i1], v[j])) j = next(j);
+            for (size_t a: {i, i1}){
+                double d = dist(v[a], v[j]);
+                if (d > best.distance) best = {a, j, d};
+            }
+        }
+        return best;
+    }
+
+    /**
+     * Minimum distance between two parallel supporting lines, by rotating calipers
+     * One of the lines always contains a hull edge
+     * Time Complexity: O(h)
+     */
+    width_result width() const{
+        size_t h = v.size();
+        if (h < 3) return {0, h > 1 ? (size_t)1 : 0, 0};
+        width_result best{0, 0, INFINITY};
+        size_t j = 1;
+        for (size_t i = 0; i < h; i++){
+            size_t i1 = next(i);
+            while (area2(v[i], v[i1], v[next(j)]) > area2(v[i], v[i1], v[j])) j = next(j);
+            double w = area2(v[i], v[i1], v[j]) / dist(v[i], v[i1]);
+            if (w < best.width) best = {i, j, w};
+        }
+        return best;
+    }
+
+    /**
+     * Minimum area enclosing rectangle by rotating calipers
+     * One side of the optimal rectangle always contains a hull edge, so every edge is tried
+     * with three calipers tracking the extreme vertices along and across it
+     * Time Complexity: O(h)
+     */
+    rect_result min_area_rect() const{
+        size_t h = v.size();
+        rect_result best{};
+        best.area = INFINITY;
+        if (h < 3){
+            for (auto &c: best.corners) c = h ? point<double>((double)v[0].X(), (double)v[0].Y()) : point<double>();
+            if (h == 2){
+                best.corners[1] = best.corners[2] = point<double>((double)v[1].X(), (double)v[1].Y());
+            }
+            best.area = 0;
+            return best;
+        }
+        auto along = [&](size_t a, size_t b, double ux, double uy){
+            return ((double)v[b].X() - (double)v[a].X()) * ux + ((double)v[b].Y() - (double)v[a].Y()) * uy;
+        };
+        size_t r = 0, t = 0, l = 0;
+        for (size_t i = 0; i < h; i++){
+            size_t i1 = next(i);
+            double len = dist(v[i], v[i1]);
+            double ux = ((double)v[i1].X() - (double)v[i].X()) / len, uy = ((double)v[i1].Y() - (double)v[i].Y()) / len;
+            double nx = -uy, ny = ux;  // inward normal
+            if (i == 0) r = i1;
+            while (along(r, next(r), ux, uy) > 0) r = next(r);
+            if (i == 0) t = r;
+            while (along(t, next(t), nx, ny) > 0) t = next(t);
+            if (i == 0) l = t;
+            while (along(l, next(l), ux, uy) < 0) l = next(l);
+            double minU = along(i, l, ux, uy), maxU = along(i, r, ux, uy), height = along(i, t, nx, ny);
+            double area = (maxU - minU) * height;
+            if (area < best.area){
+                double ox = (double)v[i].X(), oy = (double)v[i].Y();
+                best.area = area;
+                best.corners = {point<double>(ox + ux * minU, oy + uy * minU),
+                                point<double>(ox + ux * maxU, oy + uy * maxU),
+                                point<double>(ox + ux * maxU + nx * height, oy + uy * maxU + ny * height),
+                                point<double>(ox + ux * minU + nx * height, oy + uy * minU + ny * height)};
+            }
+        }
+        return best;
+    }
+
+    /**
+     * contains() for every query, split across threads
+     * Time Complexity: O(m log h / threads)
+     * @return result[i] is 1 if qs[i] is in the hull, otherwise 0
+     */
+    std::vector<char> contains_batch(const std::vector<point<T>> &qs, unsigned threads = std::thread::hardware_concurrency()) const{
+        std::vector<char> result(qs.size());
+        parallel_for(qs.size(), threads, [&](size_t first, size_t last){
+            for (size_t i = first; i < last; i++) result[i] = contains(qs[i]);
+        });
+        return result;
+    }
+
+    /**
+     * extreme() for every direction, split across threads
+     * Time Complexity: O(m log h / threads)
+     */
+    std::vector<size_t> extreme_batch(const std::vector<point<T>> &directions, unsigned threads = std::thread::hardware_concurrency()) const{
+        std::vector<size_t> result(directions.size());
+        parallel_for(directions.size(), threads, [&](size_t first, size_t last){
+            for (size_t i = first; i < last; i++) result[i] = extreme(directions[i].X(), directions[i].Y());
+        });
+        return result;
+    }
+};
+
+#endif //VE281P1_HULL_QUERY_HPP
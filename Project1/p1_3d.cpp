@@ -0,0 +1,27 @@
+#include "quickhull.hpp"
+#include <cstring>
+#include <iostream>
+#include <vector>
+using namespace std;
+
+int main(int argc, char *argv[]){
+    bool parallel = argc > 1 && strcmp(argv[1], "-p") == 0;
+    int N = 0;
+    cin >> N;
+    vector<point3<double>> vp;
+    vp.reserve((size_t)max(N, 0));
+    for (int n=0; n<N; n++){
+        double x, y, z;
+        cin >> x >> y >> z;
+        vp.push_back(point3<double>{x, y, z});
+    }
+    try{
+        hull3<double> h = parallel ? quickhull_parallel(vp) : quickhull(vp);
+        h.print();
+    }
+    catch (const std::domain_error &e){
+        cerr << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,232 @@
+#ifndef VE281P1_PREDICATE_HPP
+#define VE281P1_PREDICATE_HPP
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+/**
+ * Orientation predicates for 2D points
+ * orient(a, b, c) returns the sign of
+ *     (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x)
+ * i.e. 1 if a->b->c turns counterclockwise, -1 if clockwise, 0 if collinear.
+ * dot(a, b, d) returns the sign of (b.x - a.x) * d.x + (b.y - a.y) * d.y,
+ * i.e. whether b is ahead of a in direction d.
+ * The result is always exact:
+ * - 32-bit integers are evaluated in 64/128-bit arithmetic
+ * - 64-bit integers are evaluated in 128-bit arithmetic, exact for |x|, |y| <= 2^62
+ * - doubles use a floating-point filter and fall back to expansion arithmetic
+ *   only when the filter can not certify the sign
+ */
+namespace predicate {
+
+__extension__ typedef __int128 int128_t;
+
+template <typename T>
+inline int sign(T v) { return (v > 0) - (v < 0); }
+
+/**
+ * Exact double arithmetic helpers (Dekker / Shewchuk)
+ * Every operation returns the rounded result in hi and the round-off in lo
+ */
+namespace exact {
+
+// 2^27 + 1, splits a double into two 26-bit halves
+static constexpr double SPLITTER = 134217729.0;
+
+inline void two_sum(double a, double b, double &hi, double &lo)
+{
+    hi = a + b;
+    double bVirtual = hi - a;
+    double aVirtual = hi - bVirtual;
+    lo = (a - aVirtual) + (b - bVirtual);
+}
+
+inline void split(double a, double &hi, double &lo)
+{
+    double c = SPLITTER * a;
+    hi = c - (c - a);
+    lo = a - hi;
+}
+
+inline void two_product(double a, double b, double &hi, double &lo)
+{
+    hi = a * b;
+    double aHi, aLo, bHi, bLo;
+    split(a, aHi, aLo);
+    split(b, bHi, bLo);
+    lo = ((aHi * bHi - hi) + aHi * bLo + aLo * bHi) + aLo * bLo;
+}
+
+/**
+ * Add b into the non-overlapping expansion e[0..len), increasing magnitude
+ * Zero components are eliminated
+ * @return the new length of e
+ */
+inline int grow_expansion(double *e, int len, double b)
+{
+    double q = b;
+    int k = 0;
+    for (int i = 0; i < len; i++)
+    {
+        double hi, lo;
+        two_sum(q, e[i], hi, lo);
+        q = hi;
+        if (lo != 0.0) e[k++] = lo;
+    }
+    if (q != 0.0) e[k++] = q;
+    return k;
+}
+
+/**
+ * Sign of the sum of products terms[0][0] * terms[0][1] + ... without any rounding
+ * Time Complexity: O(n^2), n <= 6
+ */
+inline int sign_of_products(const double (*terms)[2], int n)
+{
+    double e[12];
+    int len = 0;
+    for (int i = 0; i < n; i++)
+    {
+        double hi, lo;
+        two_product(terms[i][0], terms[i][1], hi, lo);
+        len = grow_expansion(e, len, lo);
+        len = grow_expansion(e, len, hi);
+    }
+    return len == 0 ? 0 : sign(e[len - 1]);
+}
+
+/**
+ * Sign of ax*by + bx*cy + cx*ay - ay*bx - by*cx - cy*ax without any rounding
+ */
+inline int orient2d(double ax, double ay, double bx, double by, double cx, double cy)
+{
+    const double terms[6][2] = {{ax, by}, {bx, cy}, {cx, ay}, {-ay, bx}, {-by, cx}, {-cy, ax}};
+    return sign_of_products(terms, 6);
+}
+
+/**
+ * Sign of bx*dx - ax*dx + by*dy - ay*dy without any rounding
+ */
+inline int dot2d(double ax, double ay, double bx, double by, double dx, double dy)
+{
+    const double terms[4][2] = {{bx, dx}, {-ax, dx}, {by, dy}, {-ay, dy}};
+    return sign_of_products(terms, 4);
+}
+
+} // namespace exact
+
+template <typename T, typename = void>
+struct orientation;
+
+/**
+ * Integers up to 32 bits: differences fit in 33 bits and products in 66 bits,
+ * so differences are taken in 64 bits and the products in 128 bits
+ */
+template <typename T>
+struct orientation<T, typename std::enable_if<std::is_integral<T>::value && (sizeof(T) <= 4)>::type>
+{
+    int operator()(T ax, T ay, T bx, T by, T cx, T cy) const
+    {
+        int64_t abx = (int64_t)bx - ax, aby = (int64_t)by - ay;
+        int64_t acx = (int64_t)cx - ax, acy = (int64_t)cy - ay;
+        int128_t det = (int128_t)abx * acy - (int128_t)aby * acx;
+        return sign(det);
+    }
+
+    int dot(T ax, T ay, T bx, T by, T dx, T dy) const
+    {
+        int128_t abx = (int64_t)bx - ax, aby = (int64_t)by - ay;
+        return sign(abx * dx + aby * dy);
+    }
+};
+
+/**
+ * 64-bit integers: evaluated in 128-bit arithmetic
+ * Exact as long as every coordinate satisfies |x| <= 2^62
+ */
+template <typename T>
+struct orientation<T, typename std::enable_if<std::is_integral<T>::value && (sizeof(T) == 8)>::type>
+{
+    int operator()(T ax, T ay, T bx, T by, T cx, T cy) const
+    {
+        int128_t abx = (int128_t)bx - ax, aby = (int128_t)by - ay;
+        int128_t acx = (int128_t)cx - ax, acy = (int128_t)cy - ay;
+        int128_t det = abx * acy - aby * acx;
+        return sign(det);
+    }
+
+    int dot(T ax, T ay, T bx, T by, T dx, T dy) const
+    {
+        int128_t abx = (int128_t)bx - ax, aby = (int128_t)by - ay;
+        return sign(abx * dx + aby * dy);
+    }
+};
+
+/**
+ * Floating point: Shewchuk's stage-A filter, then the exact expansion fallback
+ * The filter succeeds unless the three points are (nearly) collinear
+ */
+template <typename T>
+struct orientation<T, typename std::enable_if<std::is_floating_point<T>::value>::type>
+{
+    // (3 + 16 eps) eps, eps = 2^-53
+    static constexpr double ERRBOUND =
+        (3.0 + 16.0 * (std::numeric_limits<double>::epsilon() / 2)) * (std::numeric_limits<double>::epsilon() / 2);
+
+    int operator()(T ax, T ay, T bx, T by, T cx, T cy) const
+    {
+        double detLeft = ((double)ax - (double)cx) * ((double)by - (double)cy);
+        double detRight = ((double)ay - (double)cy) * ((double)bx - (double)cx);
+        double det = detLeft - detRight;
+        double detSum;
+        if (detLeft > 0.0)
+        {
+            if (detRight <= 0.0) return sign(det);
+            detSum = detLeft + detRight;
+        }
+        else if (detLeft < 0.0)
+        {
+            if (detRight >= 0.0) return sign(det);
+            detSum = -detLeft - detRight;
+        }
+        else
+        {
+            return sign(det);
+        }
+        double errBound = ERRBOUND * detSum;
+        if (det >= errBound || -det >= errBound)
+        {
+            return sign(det);
+        }
+        return exact::orient2d((double)ax, (double)ay, (double)bx, (double)by, (double)cx, (double)cy);
+    }
+
+    // Same filter: each product carries one rounded difference instead of two, so the bound is safe
+    int dot(T ax, T ay, T bx, T by, T dx, T dy) const
+    {
+        double left = ((double)bx - (double)ax) * (double)dx;
+        double right = ((double)by - (double)ay) * (double)dy;
+        double sum = left + right;
+        double errBound = ERRBOUND * (std::fabs(left) + std::fabs(right));
+        if (sum > errBound || -sum > errBound)
+        {
+            return sign(sum);
+        }
+        return exact::dot2d((double)ax, (double)ay, (double)bx, (double)by, (double)dx, (double)dy);
+    }
+};
+
+/**
+ * Time Complexity: O(1)
+ * @return 1 if a->b->c is counterclockwise, -1 if clockwise, 0 if collinear
+ */
+template <typename T>
+inline int orient2d(T ax, T ay, T bx, T by, T cx, T cy)
+{
+    return orientation<T>()(ax, ay, bx, by, cx, cy);
+}
+
+} // namespace predicate
+
+#endif //VE281P1_PREDICATE_HPP
@@ -0,0 +1,496 @@
+#ifndef VE281P1_QUICKHULL_HPP
+#define VE281P1_QUICKHULL_HPP
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * A 3D point
+ * @tparam T coordinate type, the geometry is evaluated in double
+ */
+template <typename T>
+struct point3{
+    T x;
+    T y;
+    T z;
+};
+
+/**
+ * Output of the 3D hull
+ * Faces are triangles indexing into vertices, counterclockwise seen from outside
+ */
+template <typename T>
+struct hull3{
+    std::vector<point3<T>> vertices;
+    std::vector<std::array<size_t, 3>> faces;
+
+    void print() const{
+        std::cout << vertices.size() << " " << faces.size() << "\n";
+        for (auto &v: vertices){
+            std::cout << v.x << " " << v.y << " " << v.z << "\n";
+        }
+        for (auto &f: faces){
+            std::cout << f[0] << " " << f[1] << " " << f[2] << "\n";
+        }
+    }
+};
+
+/**
+ * The Quickhull algorithm in 3D
+ * The hull is kept as a half-edge mesh, faces and half-edges live in pools
+ * (vectors with free lists) so deleted faces are recycled instead of reallocated.
+ * Every face keeps the conflict list of the outside points it sees; the farthest
+ * point of a face is always added first.
+ * Points within tolerance of a face are treated as coplanar and dropped; on degenerate
+ * input (e.g. grids) a coplanar boundary point may still appear as a vertex if it is
+ * added before the corners around it.
+ * Time Complexity: expected O(n log n)
+ * @tparam T coordinate type
+ */
+template <typename T>
+class QuickHull3D{
+private:
+    struct HalfEdge{
+        int origin;  // index of the tail vertex in points
+        int next;    // next half-edge of the same face
+        int twin;    // the opposite half-edge
+        int face;
+    };
+
+    struct Face{
+        int edge = -1;          // any half-edge of the face
+        double nx = 0, ny = 0, nz = 0, offset = 0;  // outward unit normal, plane offset
+        std::vector<size_t> conflict;  // outside points this face sees
+        size_t farthest = 0;
+        double farthestDist = 0;
+        unsigned mark = 0;      // stamp of the last visibility test
+        bool visible = false;   // result of the last visibility test
+        bool alive = false;
+    };
+
+    const std::vector<point3<T>> &points;
+    double tolerance;
+    std::vector<HalfEdge> edges;
+    std::vector<int> freeEdges;
+    std::vector<Face> faces;
+    std::vector<int> freeFaces;
+    std::vector<int> pending;  // faces which may have a non-empty conflict list
+    unsigned stamp = 0;
+
+    double px(size_t i) const {return (double)points[i].x;}
+    double py(size_t i) const {return (double)points[i].y;}
+    double pz(size_t i) const {return (double)points[i].z;}
+
+    double distance(const Face &f, size_t i) const{
+        return f.nx * px(i) + f.ny * py(i) + f.nz * pz(i) - f.offset;
+    }
+
+    int newEdge(int origin, int face){
+        int e;
+        if (!freeEdges.empty()){
+            e = freeEdges.back();
+            freeEdges.pop_back();
+        }
+        else{
+            e = (int)edges.size();
+            edges.emplace_back();
+        }
+        edges[(size_t)e] = HalfEdge{origin, -1, -1, face};
+        return e;
+    }
+
+    /**
+     * Allocate the triangle a->b->c and compute its plane, twins are left unset
+     * @return the face index, faces[f].edge is the half-edge a->b
+     */
+    int newFace(int a, int b, int c){
+        int f;
+        if (!freeFaces.empty()){
+            f = freeFaces.back();
+            freeFaces.pop_back();
+        }
+        else{
+            f = (int)faces.size();
+            faces.emplace_back();
+        }
+        int e0 = newEdge(a, f), e1 = newEdge(b, f), e2 = newEdge(c, f);
+        edges[(size_t)e0].next = e1;
+        edges[(size_t)e1].next = e2;
+        edges[(size_t)e2].next = e0;
+        Face &face = faces[(size_t)f];
+        face.edge = e0;
+        face.conflict.clear();
+        face.farthestDist = 0;
+        face.mark = 0;
+        face.visible = false;
+        face.alive = true;
+        size_t ia = (size_t)a, ib = (size_t)b, ic = (size_t)c;
+        double ux = px(ib) - px(ia), uy = py(ib) - py(ia), uz = pz(ib) - pz(ia);
+        double vx = px(ic) - px(ia), vy = py(ic) - py(ia), vz = pz(ic) - pz(ia);
+        double nx = uy * vz - uz * vy, ny = uz * vx - ux * vz, nz = ux * vy - uy * vx;
+        double len = std::sqrt(nx * nx + ny * ny + nz * nz);
+        if (len > 0){
+            nx /= len; ny /= len; nz /= len;
+        }
+        face.nx = nx; face.ny = ny; face.nz = nz;
+        face.offset = (nx * (px(ia) + px(ib) + px(ic)) + ny * (py(ia) + py(ib) + py(ic)) + nz * (pz(ia) + pz(ib) + pz(ic))) / 3;
+        return f;
+    }
+
+    void deleteFace(int f){
+        Face &face = faces[(size_t)f];
+        int e = face.edge;
+        for (int k = 0; k < 3; k++){
+            freeEdges.push_back(e);
+            e = edges[(size_t)e].next;
+        }
+        face.alive = false;
+        face.conflict.clear();
+        freeFaces.push_back(f);
+    }
+
+    void addConflict(int f, size_t i, double dist){
+        Face &face = faces[(size_t)f];
+        if (face.conflict.empty()){
+            pending.push_back(f);
+        }
+        if (face.conflict.empty() || dist > face.farthestDist){
+            face.farthest = i;
+            face.farthestDist = dist;
+        }
+        face.conflict.push_back(i);
+    }
+
+    /**
+     * Put point i into the conflict list of the face among fs it is farthest above
+     * Points inside (or within tolerance of) all faces are discarded
+     */
+    void assign(size_t i, const std::vector<int> &fs){
+        int best = -1;
+        double bestDist = tolerance;
+        for (int f: fs){
+            double dist = distance(faces[(size_t)f], i);
+            if (dist > bestDist){
+                best = f;
+                bestDist = dist;
+            }
+        }
+        if (best >= 0) addConflict(best, i, bestDist);
+    }
+
+    /**
+     * Add the farthest conflict point of face f to the hull
+     * Find the visible faces and their horizon, replace the visible faces with a cone
+     * from the eye point and redistribute their conflict points
+     */
+    void addPoint(int f){
+        size_t eye = faces[(size_t)f].farthest;
+        ++stamp;
+        std::vector<int> visible{f};
+        std::vector<int> horizon;
+        faces[(size_t)f].mark = stamp;
+        faces[(size_t)f].visible = true;
+        for (size_t k = 0; k < visible.size(); k++){
+            int e = faces[(size_t)visible[k]].edge;
+            for (int j = 0; j < 3; j++, e = edges[(size_t)e].next){
+                Face &g = faces[(size_t)edges[(size_t)edges[(size_t)e].twin].face];
+                if (g.mark != stamp){
+                    g.mark = stamp;
+                    g.visible = distance(g, eye) > tolerance;
+                    if (g.visible){
+                        visible.push_back(edges[(size_t)edges[(size_t)e].twin].face);
+                        continue;
+                    }
+                }
+                if (!g.visible) horizon.push_back(e);
+            }
+        }
+
+        std::vector<size_t> orphans;
+        std::vector<std::array<int, 3>> rim;  // origin, destination, outer twin of each horizon edge
+        rim.reserve(horizon.size());
+        for (int e: horizon){
+            const HalfEdge &he = edges[(size_t)e];
+            rim.push_back({he.origin, edges[(size_t)he.next].origin, he.twin});
+        }
+        for (int v: visible){
+            for (size_t i: faces[(size_t)v].conflict){
+                if (i != eye) orphans.push_back(i);
+            }
+            deleteFace(v);
+        }
+
+        std::vector<int> cone;
+        cone.reserve(rim.size());
+        std::unordered_map<int, int> spokeTo;  // vertex a -> half-edge eye->a
+        for (auto &r: rim){
+            int nf = newFace(r[0], r[1], (int)eye);
+            int e0 = faces[(size_t)nf].edge;
+            edges[(size_t)e0].twin = r[2];
+            edges[(size_t)r[2]].twin = e0;
+            spokeTo[r[0]] = edges[(size_t)edges[(size_t)e0].next].next;
+            cone.push_back(nf);
+        }
+        for (int nf: cone){
+            int e1 = edges[(size_t)faces[(size_t)nf].edge].next;  // b->eye
+            int e2 = spokeTo.at(edges[(size_t)e1].origin);        // eye->b
+            edges[(size_t)e1].twin = e2;
+            edges[(size_t)e2].twin = e1;
+        }
+        for (size_t i: orphans){
+            assign(i, cone);
+        }
+    }
+
+    static void linkTwins(std::vector<HalfEdge> &edges, const std::vector<int> &ids){
+        for (int a: ids){
+            for (int b: ids){
+                if (edges[(size_t)a].origin == edges[(size_t)edges[(size_t)b].next].origin &&
+                    edges[(size_t)b].origin == edges[(size_t)edges[(size_t)a].next].origin){
+                    edges[(size_t)a].twin = b;
+                }
+            }
+        }
+    }
+
+public:
+    QuickHull3D(const std::vector<point3<T>> &points, double tolerance) : points(points), tolerance(tolerance) {}
+
+    /**
+     * Tolerance for the plane tests, scaled with the magnitude of the input
+     * Time Complexity: O(n)
+     */
+    static double defaultTolerance(const std::vector<point3<T>> &points){
+        double mx = 0, my = 0, mz = 0;
+        for (auto &p: points){
+            mx = std::max(mx, std::fabs((double)p.x));
+            my = std::max(my, std::fabs((double)p.y));
+            mz = std::max(mz, std::fabs((double)p.z));
+        }
+        return 3 * std::numeric_limits<double>::epsilon() * (mx + my + mz);
+    }
+
+    /**
+     * Choose four extreme points spanning a tetrahedron
+     * The last point lies above the plane of the first three (counterclockwise seen from it)
+     * Time Complexity: O(n)
+     * @throw std::domain_error if all points are coplanar
+     */
+    static std::array<size_t, 4> initialSimplex(const std::vector<point3<T>> &points, double tolerance){
+        if (points.size() < 4) throw std::domain_error("Need at least 4 points for a 3D hull");
+        auto coord = [&](size_t i, int axis){
+            return axis == 0 ? (double)points[i].x : axis == 1 ? (double)points[i].y : (double)points[i].z;
+        };
+        std::array<size_t, 3> lo{0, 0, 0}, hi{0, 0, 0};
+        for (size_t i = 1; i < points.size(); i++){
+            for (int a = 0; a < 3; a++){
+                if (coord(i, a) < coord(lo[(size_t)a], a)) lo[(size_t)a] = i;
+                if (coord(i, a) > coord(hi[(size_t)a], a)) hi[(size_t)a] = i;
+            }
+        }
+        std::array<size_t, 4> s{};
+        double spread = -1;
+        for (size_t a = 0; a < 3; a++){
+            double d = coord(hi[a], (int)a) - coord(lo[a], (int)a);
+            if (d > spread){
+                spread = d;
+                s[0] = lo[a];
+                s[1] = hi[a];
+            }
+        }
+        if (spread <= tolerance) throw std::domain_error("Degenerate input: all points coincide");
+
+        double dx = coord(s[1], 0) - coord(s[0], 0), dy = coord(s[1], 1) - coord(s[0], 1), dz = coord(s[1], 2) - coord(s[0], 2);
+        double best = -1;
+        for (size_t i = 0; i < points.size(); i++){
+            double ux = coord(i, 0) - coord(s[0], 0), uy = coord(i, 1) - coord(s[0], 1), uz = coord(i, 2) - coord(s[0], 2);
+            double cx = uy * dz - uz * dy, cy = uz * dx - ux * dz, cz = ux * dy - uy * dx;
+            double d = cx * cx + cy * cy + cz * cz;
+            if (d > best){
+                best = d;
+                s[2] = i;
+            }
+        }
+        if (std::sqrt(best) <= tolerance * std::sqrt(dx * dx + dy * dy + dz * dz)) throw std::domain_error("Degenerate input: all points are collinear");
+
+        double vx = coord(s[2], 0) - coord(s[0], 0), vy = coord(s[2], 1) - coord(s[0], 1), vz = coord(s[2], 2) - coord(s[0], 2);
+        double nx = dy * vz - dz * vy, ny = dz * vx - dx * vz, nz = dx * vy - dy * vx;
+        double len = std::sqrt(nx * nx + ny * ny + nz * nz);
+        best = 0;
+        double bestSigned = 0;
+        for (size_t i = 0; i < points.size(); i++){
+            double d = (nx * (coord(i, 0) - coord(s[0], 0)) + ny * (coord(i, 1) - coord(s[0], 1)) + nz * (coord(i, 2) - coord(s[0], 2))) / len;
+            if (std::fabs(d) > best){
+                best = std::fabs(d);
+                bestSigned = d;
+                s[3] = i;
+            }
+        }
+        if (best <= tolerance) throw std::domain_error("Degenerate input: all points are coplanar");
+        if (bestSigned < 0) std::swap(s[1], s[2]);
+        return s;
+    }
+
+    /**
+     * Build the hull of the simplex and the candidate points
+     * Time Complexity: expected O(m log m), m = candidates.size()
+     * @param simplex result of initialSimplex
+     * @param candidates indices of the other points to consider
+     */
+    void run(const std::array<size_t, 4> &simplex, const std::vector<size_t> &candidates){
+        int a = (int)simplex[0], b = (int)simplex[1], c = (int)simplex[2], d = (int)simplex[3];
+        std::vector<int> tetra{newFace(a, c, b), newFace(a, b, d), newFace(b, c, d), newFace(c, a, d)};
+        std::vector<int> tetraEdges;
+        for (int f: tetra){
+            int e = faces[(size_t)f].edge;
+            for (int k = 0; k < 3; k++, e = edges[(size_t)e].next) tetraEdges.push_back(e);
+        }
+        linkTwins(edges, tetraEdges);
+        for (size_t i: candidates){
+            if (i != simplex[0] && i != simplex[1] && i != simplex[2] && i != simplex[3]){
+                assign(i, tetra);
+            }
+        }
+        while (!pending.empty()){
+            int f = pending.back();
+            pending.pop_back();
+            if (faces[(size_t)f].alive && !faces[(size_t)f].conflict.empty()){
+                addPoint(f);
+            }
+        }
+    }
+
+    /**
+     * Assign the candidates to the simplex faces, the first step of run
+     * Time Complexity: O(m)
+     * @return the face (0..3) each candidate sees the farthest, or -1 if it is inside
+     */
+    static std::vector<int> partition(const std::vector<point3<T>> &points, double tolerance,
+                                      const std::array<size_t, 4> &simplex, size_t first, size_t last){
+        QuickHull3D qh(points, tolerance);
+        int a = (int)simplex[0], b = (int)simplex[1], c = (int)simplex[2], d = (int)simplex[3];
+        std::array<int, 4> tetra{qh.newFace(a, c, b), qh.newFace(a, b, d), qh.newFace(b, c, d), qh.newFace(c, a, d)};
+        std::vector<int> owner(last - first, -1);
+        for (size_t i = first; i < last; i++){
+            double bestDist = tolerance;
+            for (int k = 0; k < 4; k++){
+                double dist = qh.distance(qh.faces[(size_t)tetra[(size_t)k]], i);
+                if (dist > bestDist){
+                    bestDist = dist;
+                    owner[i - first] = k;
+                }
+            }
+        }
+        return owner;
+    }
+
+    /**
+     * @return indices (into points) of the hull vertices, sorted
+     */
+    std::vector<size_t> vertexIds() const{
+        std::vector<size_t> ids;
+        for (auto &f: faces){
+            if (!f.alive) continue;
+            int e = f.edge;
+            for (int k = 0; k < 3; k++, e = edges[(size_t)e].next) ids.push_back((size_t)edges[(size_t)e].origin);
+        }
+        std::sort(ids.begin(), ids.end());
+        ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+        return ids;
+    }
+
+    hull3<T> result() const{
+        hull3<T> h;
+        std::unordered_map<size_t, size_t> index;
+        for (size_t i: vertexIds()){
+            index[i] = h.vertices.size();
+            h.vertices.push_back(points[i]);
+        }
+        for (auto &f: faces){
+            if (!f.alive) continue;
+            int e = f.edge;
+            std::array<size_t, 3> tri{};
+            for (size_t k = 0; k < 3; k++, e = edges[(size_t)e].next) tri[k] = index[(size_t)edges[(size_t)e].origin];
+            h.faces.push_back(tri);
+        }
+        return h;
+    }
+};
+
+/**
+ * Sequential 3D quickhull
+ * @throw std::domain_error if the points do not span a volume
+ */
+template <typename T>
+hull3<T> quickhull(const std::vector<point3<T>> &vp){
+    double tolerance = QuickHull3D<T>::defaultTolerance(vp);
+    auto simplex = QuickHull3D<T>::initialSimplex(vp, tolerance);
+    std::vector<size_t> all(vp.size());
+    for (size_t i = 0; i < all.size(); i++) all[i] = i;
+    QuickHull3D<T> qh(vp, tolerance);
+    qh.run(simplex, all);
+    return qh.result();
+}
+
+/**
+ * Parallel 3D quickhull
+ * The points are partitioned by the face of the initial simplex they see (in parallel),
+ * the hull of each part together with the simplex is built on its own thread,
+ * and a final pass merges the (much smaller) vertex sets of the four partial hulls.
+ * Every vertex of the whole hull is a vertex of the partial hull containing it,
+ * so the result is the same hull as the sequential one.
+ * @param threads number of worker threads
+ * @throw std::domain_error if the points do not span a volume
+ */
+template <typename T>
+hull3<T> quickhull_parallel(const std::vector<point3<T>> &vp, unsigned threads = std::thread::hardware_concurrency()){
+    if (threads <= 1) return quickhull(vp);
+    double tolerance = QuickHull3D<T>::defaultTolerance(vp);
+    auto simplex = QuickHull3D<T>::initialSimplex(vp, tolerance);
+
+    std::vector<std::vector<int>> owners(threads);
+    std::vector<std::thread> workers;
+    size_t chunk = (vp.size() + threads - 1) / threads;
+    for (unsigned t = 0; t < threads; t++){
+        size_t first = std::min(vp.size(), t * chunk), last = std::min(vp.size(), first + chunk);
+        workers.emplace_back([&, t, first, last](){
+            owners[t] = QuickHull3D<T>::partition(vp, tolerance, simplex, first, last);
+        });
+    }
+    for (auto &w: workers) w.join();
+    workers.clear();
+
+    std::array<std::vector<size_t>, 4> parts;
+    for (unsigned t = 0; t < threads; t++){
+        for (size_t j = 0; j < owners[t].size(); j++){
+            if (owners[t][j] >= 0) parts[(size_t)owners[t][j]].push_back(t * chunk + j);
+        }
+    }
+    owners.clear();
+
+    std::array<std::vector<size_t>, 4> partial;
+    for (size_t k = 0; k < 4; k++){
+        workers.emplace_back([&, k](){
+            QuickHull3D<T> qh(vp, tolerance);
+            qh.run(simplex, parts[k]);
+            partial[k] = qh.vertexIds();
+        });
+    }
+    for (auto &w: workers) w.join();
+
+    std::vector<size_t> merged;
+    for (auto &p: partial) merged.insert(merged.end(), p.begin(), p.end());
+    std::sort(merged.begin(), merged.end());
+    merged.erase(std::unique(merged.begin(), merged.end()), merged.end());
+    QuickHull3D<T> qh(vp, tolerance);
+    qh.run(simplex, merged);
+    return qh.result();
+}
+
+#endif //VE281P1_QUICKHULL_HPP
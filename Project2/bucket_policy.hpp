@@ -0,0 +1,91 @@
+#ifndef VE281P2_BUCKET_POLICY_HPP
+#define VE281P2_BUCKET_POLICY_HPP
+#include "hash_prime.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+/**
+ * Bucket count policies of the HashTable
+ * A policy decides which bucket counts are allowed and maps a hash value to a bucket
+ * - static size_t roundUp(size_t n): the minimum allowed bucket count >= n
+ *   @throw std::range_error if no such bucket count can be found
+ * - void reset(size_t bucketSize): prepare for bucketSize buckets (a result of roundUp)
+ * - size_t bucket(size_t hashValue) const: bucket index in [0, bucketSize)
+ */
+
+/**
+ * Prime bucket counts from HashPrime, reduced with Lemire's fastmod
+ * instead of a 64-bit division by a runtime prime
+ */
+class PrimeBucketPolicy
+{
+private:
+    uint64_t divisor = 1;
+    HashPrime::uint128_t magic = 0;
+
+public:
+    static size_t roundUp(size_t n)
+    {
+        const size_t* first = HashPrime::g_a_sizes;
+        const size_t* last = HashPrime::g_a_sizes + HashPrime::num_distinct_sizes;
+        const size_t* it = std::lower_bound(first, last, n);
+        if (it == last)
+        {
+            throw std::range_error("No such bucket size");
+        }
+        return *it;
+    }
+
+    void reset(size_t bucketSize)
+    {
+        const size_t* first = HashPrime::g_a_sizes;
+        size_t index = (size_t)(std::lower_bound(first, first + HashPrime::num_distinct_sizes, bucketSize) - first);
+        divisor = bucketSize;
+        magic = HashPrime::g_a_fastmod.magic[index];
+    }
+
+    size_t bucket(size_t hashValue) const
+    {
+        return HashPrime::fastmod(hashValue, magic, divisor);
+    }
+};
+
+/**
+ * Power of 2 bucket counts
+ * A bare mask would only keep the low bits of the hash (and std::hash of an integer is
+ * the identity), so the hash is first mixed by Fibonacci hashing, keeping the high bits
+ */
+class PowerOfTwoBucketPolicy
+{
+private:
+    unsigned shift = 63;
+
+public:
+    static constexpr size_t MIN_BUCKET_SIZE = 8;
+
+    static size_t roundUp(size_t n)
+    {
+        size_t result = MIN_BUCKET_SIZE;
+        while (result < n)
+        {
+            if (result > (SIZE_MAX >> 1))
+            {
+                throw std::range_error("No such bucket size");
+            }
+            result <<= 1;
+        }
+        return result;
+    }
+
+    void reset(size_t bucketSize)
+    {
+        shift = 64 - (unsigned)__builtin_ctzll(bucketSize);
+    }
+
+    size_t bucket(size_t hashValue) const
+    {
+        return (size_t)(((uint64_t)hashValue * 0x9E3779B97F4A7C15ULL) >> shift);
+    }
+};
+
+#endif //VE281P2_BUCKET_POLICY_HPP
@@ -0,0 +1,131 @@
+#include "hashtable.hpp"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+using namespace std;
+
+// Usage: ./bucket_policy_performance [max_exponent=7] [seed]
+// Sizes run from 10^4 to 10^max_exponent, on long keys (std::hash<long> is the identity)
+// Output (CSV): policy,keys,n,insert,find_hit,find_miss (nanoseconds per operation)
+
+/**
+ * The reduction used before bucket policies: prime bucket counts and a 64-bit division
+ */
+class DivisionBucketPolicy
+{
+private:
+    size_t divisor = 1;
+
+public:
+    static size_t roundUp(size_t n) { return PrimeBucketPolicy::roundUp(n); }
+    void reset(size_t bucketSize) { divisor = bucketSize; }
+    size_t bucket(size_t hashValue) const { return hashValue % divisor; }
+};
+
+vector<long> gen_sequential(size_t n, mt19937_64 &)
+{
+    vector<long> keys(n);
+    for (size_t i = 0; i < n; i++)
+    {
+        keys[i] = (long)i;
+    }
+    return keys;
+}
+
+vector<long> gen_random(size_t n, mt19937_64 &gen)
+{
+    uniform_int_distribution<long> u(0, INT32_MAX);
+    vector<long> keys(n);
+    for (auto &k : keys)
+    {
+        k = u(gen);
+    }
+    return keys;
+}
+
+// Multiples of 1024: only the low bits are constant, which a bare mask would map to one bucket
+// (long keys, as i << 10 overflows an int from i = 2^21 on)
+vector<long> gen_strided(size_t n, mt19937_64 &)
+{
+    vector<long> keys(n);
+    for (size_t i = 0; i < n; i++)
+    {
+        keys[i] = (long)(i << 10);
+    }
+    return keys;
+}
+
+double ns_per_op(chrono::steady_clock::time_point &start, size_t ops)
+{
+    auto now = chrono::steady_clock::now();
+    chrono::duration<double, nano> elapsed = now - start;
+    start = now;
+    return elapsed.count() / (double)ops;
+}
+
+template <typename BucketPolicy>
+void run(const string &policy, const string &distribution, const vector<long> &keys, const vector<long> &misses)
+{
+    HashTable<long, long, hash<long>, equal_to<long>, BucketPolicy> table;
+    size_t n = keys.size();
+    auto start = chrono::steady_clock::now();
+    for (auto k : keys)
+    {
+        table.insert(k, k);
+    }
+    double insert_time = ns_per_op(start, n);
+    size_t found = 0;
+    for (auto k : keys)
+    {
+        found += table.find(k) != table.end();
+    }
+    double hit_time = ns_per_op(start, n);
+    for (auto k : misses)
+    {
+        found += table.find(k) != table.end();
+    }
+    double miss_time = ns_per_op(start, misses.size());
+    if (found != n)
+    {
+        fprintf(stderr, "%s: found %zu of %zu keys\n", policy.c_str(), found, n);
+        exit(1);
+    }
+    printf("%s,%s,%zu,%.2f,%.2f,%.2f\n", policy.c_str(), distribution.c_str(), n, insert_time, hit_time, miss_time);
+    fflush(stdout);
+}
+
+int main(int argc, char *argv[])
+{
+    int max_exponent = argc > 1 ? atoi(argv[1]) : 7;
+    unsigned long seed = argc > 2 ? strtoul(argv[2], nullptr, 10) : 281;
+    typedef vector<long> (*generator)(size_t n, mt19937_64 &gen);
+    const pair<string, generator> distributions[] = {
+        {"sequential", gen_sequential},
+        {"random", gen_random},
+        {"strided", gen_strided},
+    };
+    printf("policy,keys,n,insert,find_hit,find_miss\n");
+    for (int e = 4; e <= max_exponent; e++)
+    {
+        size_t n = (size_t)pow(10, e);
+        for (auto &d : distributions)
+        {
+            mt19937_64 gen(seed);
+            vector<long> keys = d.second(n, gen);
+            // Negative keys are never inserted
+            vector<long> misses(n);
+            for (size_t i = 0; i < n; i++)
+            {
+                misses[i] = -1 - keys[i];
+            }
+            run<DivisionBucketPolicy>("division", d.first, keys, misses);
+            run<PrimeBucketPolicy>("prime_fastmod", d.first, keys, misses);
+            run<PowerOfTwoBucketPolicy>("power_of_two", d.first, keys, misses);
+        }
+    }
+    return 0;
+}
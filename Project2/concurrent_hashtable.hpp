@@ -0,0 +1,644 @@
+#ifndef VE281P2_CONCURRENT_HASHTABLE_HPP
+#define VE281P2_CONCURRENT_HASHTABLE_HPP
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/**
+ * Epoch based reclamation, for memory that lock-free readers may still hold
+ * A reader announces the global epoch for the duration of a read (enter / exit)
+ * A writer retires what it unlinked with the epoch at that time, and the memory is
+ * freed once the global epoch is 2 ahead of it: the epoch only advances when every
+ * announced reader has caught up, so no reader can still see it
+ * One instance is shared by every ConcurrentHashTable
+ */
+class EpochReclaimer
+{
+public:
+    static constexpr size_t MAX_THREADS = 256;       // threads reading at the same time
+    static constexpr uint64_t IDLE = UINT64_MAX;     // announcement of a thread not reading
+
+private:
+    static constexpr size_t SCAN_THRESHOLD = 128;    // retired objects before a thread tries to free them
+
+    struct Retired
+    {
+        uint64_t epoch;
+        void* p;
+        void (*deleter)(void*);
+    };
+
+    struct alignas(64) Slot
+    {
+        std::atomic<uint64_t> epoch{IDLE};
+        std::atomic<bool> owned{false};
+    };
+
+    struct ThreadRecord
+    {
+        size_t slot = MAX_THREADS; // MAX_THREADS until the thread first reads
+        size_t depth = 0;          // nesting of enter
+        std::vector<Retired> retired;
+        size_t nextScan = SCAN_THRESHOLD; // size of retired at which to scan again
+
+        ~ThreadRecord()
+        {
+            instance().detach(*this);
+        }
+    };
+
+    std::atomic<uint64_t> globalEpoch{0};
+    Slot slots[MAX_THREADS];
+    std::mutex orphanLock;
+    std::vector<Retired> orphans; // left by exited threads
+
+    EpochReclaimer() = default;
+
+    static ThreadRecord& record()
+    {
+        static thread_local ThreadRecord r;
+        return r;
+    }
+
+    size_t attach()
+    {
+        for (size_t i = 0; i < MAX_THREADS; i++)
+        {
+            bool expected = false;
+            if (!slots[i].owned.load(std::memory_order_relaxed) &&
+                slots[i].owned.compare_exchange_strong(expected, true))
+            {
+                return i;
+            }
+        }
+        throw std::range_error("too many reader threads");
+    }
+
+    void detach(ThreadRecord& r)
+    {
+        if (!r.retired.empty())
+        {
+            std::lock_guard<std::mutex> lock(orphanLock);
+            orphans.insert(orphans.end(), r.retired.begin(), r.retired.end());
+            r.retired.clear();
+        }
+        if (r.slot < MAX_THREADS)
+        {
+            slots[r.slot].epoch.store(IDLE);
+            slots[r.slot].owned.store(false, std::memory_order_release);
+            r.slot = MAX_THREADS;
+        }
+    }
+
+    /**
+     * Free every object retired at least 2 epochs before epoch
+     */
+    static void freeBefore(std::vector<Retired>& list, uint64_t epoch)
+    {
+        auto kept = std::partition(list.begin(), list.end(), [epoch](const Retired& item) {
+            return item.epoch + 2 > epoch;
+        });
+        for (auto it = kept; it != list.end(); ++it)
+        {
+            it->deleter(it->p);
+        }
+        list.erase(kept, list.end());
+    }
+
+    /**
+     * Advance the global epoch if every reader announced it, then free what is old enough
+     */
+    void scan(ThreadRecord& r)
+    {
+        uint64_t epoch = globalEpoch.load();
+        bool caughtUp = true;
+        for (size_t i = 0; i < MAX_THREADS && caughtUp; i++)
+        {
+            uint64_t announced = slots[i].epoch.load();
+            caughtUp = announced == IDLE || announced == epoch;
+        }
+        if (caughtUp && globalEpoch.compare_exchange_strong(epoch, epoch + 1))
+        {
+            epoch++;
+        }
+        freeBefore(r.retired, epoch);
+        // what a stalled reader keeps alive is only walked again once the list has doubled
+        r.nextScan = r.retired.size() + std::max<size_t>(SCAN_THRESHOLD, r.retired.size());
+        std::unique_lock<std::mutex> lock(orphanLock, std::try_to_lock);
+        if (lock.owns_lock())
+        {
+            freeBefore(orphans, epoch);
+        }
+    }
+
+public:
+    EpochReclaimer(const EpochReclaimer&) = delete;
+    EpochReclaimer& operator=(const EpochReclaimer&) = delete;
+
+    ~EpochReclaimer()
+    {
+        for (auto& item : orphans)
+        {
+            item.deleter(item.p);
+        }
+    }
+
+    static EpochReclaimer& instance()
+    {
+        static EpochReclaimer reclaimer;
+        return reclaimer;
+    }
+
+    /**
+     * Start a read, nothing retired from now on is freed before the matching exit
+     * @throw std::range_error if more than MAX_THREADS threads are reading
+     */
+    void enter()
+    {
+        ThreadRecord& r = record();
+        if (r.depth++ > 0) return;
+        if (r.slot == MAX_THREADS)
+        {
+            try
+            {
+                r.slot = attach();
+            }
+            catch (...)
+            {
+                r.depth--;
+                throw;
+            }
+        }
+        slots[r.slot].epoch.store(globalEpoch.load());
+    }
+
+    void exit()
+    {
+        ThreadRecord& r = record();
+        if (--r.depth > 0) return;
+        slots[r.slot].epoch.store(IDLE, std::memory_order_release);
+    }
+
+    /**
+     * Free p with deleter once no reader can hold it, p must be unlinked already
+     * Time Complexity: Amortized O(1 + MAX_THREADS / SCAN_THRESHOLD), plus the objects left by exited threads
+     */
+    void retire(void* p, void (*deleter)(void*))
+    {
+        ThreadRecord& r = record();
+        r.retired.push_back(Retired{globalEpoch.load(), p, deleter});
+        if (r.retired.size() >= r.nextScan)
+        {
+            scan(r);
+        }
+    }
+
+    /**
+     * Holds enter / exit for a scope
+     */
+    class Guard
+    {
+    public:
+        Guard() { instance().enter(); }
+        ~Guard() { instance().exit(); }
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+    };
+};
+
+/**
+ * A hashtable shared by many threads
+ * - Writers lock one of stripeCount stripes, a key always belongs to the same stripe
+ * - Readers take no lock: nodes are immutable once published and linked by atomic
+ *   pointers, so a read is a plain traversal. Nodes are replaced rather than modified
+ *   and are only freed by the EpochReclaimer
+ * - Resizing is concurrent: each stripe is migrated to the doubled table under its own
+ *   lock, by the thread that started the resize and by any writer arriving meanwhile.
+ *   Every stripe has a version counter (a seqlock) which is odd while it is being
+ *   migrated, a reader that sees it change retries, then falls back to the lock
+ * Bucket counts are powers of 2, with bucket = hash & mask and stripe = hash & stripeMask
+ * so that the stripe of a bucket is the same in the old and the doubled table
+ * Values are returned by copy, there is no iterator
+ * @tparam Key          key type
+ * @tparam Value        data type, copied out by find
+ * @tparam Hash         function object, return the hash value of a key
+ * @tparam KeyEqual     function object, return whether two keys are the same
+ */
+template <
+    typename Key, typename Value,
+    typename Hash = std::hash<Key>,
+    typename KeyEqual = std::equal_to<Key>
+>
+class ConcurrentHashTable
+{
+protected:
+    struct Node
+    {
+        const size_t hashValue;
+        const Key key;
+        const Value value;
+        std::atomic<Node*> next;
+
+        Node(size_t hashValue, const Key& key, const Value& value, Node* next)
+            : hashValue(hashValue), key(key), value(value), next(next) {}
+    };
+
+    struct Table
+    {
+        size_t mask;
+        std::unique_ptr<std::atomic<Node*>[]> heads;
+
+        explicit Table(size_t bucketSize) : mask(bucketSize - 1), heads(new std::atomic<Node*>[bucketSize])
+        {
+            for (size_t i = 0; i < bucketSize; i++)
+            {
+                heads[i].store(nullptr, std::memory_order_relaxed);
+            }
+        }
+
+        size_t size() const { return mask + 1; }
+    };
+
+    struct alignas(64) Stripe
+    {
+        std::mutex lock;
+        std::atomic<uint64_t> version{0};    // odd while the stripe is being migrated
+        std::atomic<Table*> table{nullptr};  // the table holding the keys of this stripe
+        std::atomic<size_t> count{0};        // number of elements in this stripe
+    };
+
+    struct Resize
+    {
+        Table* target;
+        std::atomic<size_t> nextStripe{0};   // next stripe to be claimed by a migrating thread
+        std::atomic<size_t> migrated{0};     // number of stripes done
+
+        explicit Resize(Table* target) : target(target) {}
+    };
+
+    static constexpr double DEFAULT_LOAD_FACTOR = 0.5;  // default maximum load factor is 0.5
+    static constexpr size_t DEFAULT_STRIPE_COUNT = 64;
+    static constexpr size_t HELP_STRIPES = 1;           // stripes migrated by each writer during a resize
+    static constexpr int OPTIMISTIC_READS = 4;          // lock-free attempts before a reader locks
+
+    size_t stripeCount;
+    size_t stripeMask;
+    std::unique_ptr<Stripe[]> stripes;
+    std::atomic<Table*> current;           // the newest table every stripe has migrated to
+    std::atomic<Resize*> resize{nullptr};  // the resize in progress
+    std::mutex resizeLock;                 // held to start a resize
+    double maxLoadFactor;                  // maximum load factor
+    Hash hash;                             // hash function instance
+    KeyEqual keyEqual;                     // key equal function instance
+
+    static void deleteNode(void* p) { delete static_cast<Node*>(p); }
+    static void deleteTable(void* p) { delete static_cast<Table*>(p); }
+    static void deleteResize(void* p) { delete static_cast<Resize*>(p); }
+
+    static size_t roundUpPowerOfTwo(size_t n)
+    {
+        size_t result = 1;
+        while (result < n) result <<= 1;
+        return result;
+    }
+
+    /**
+     * The bucket and the stripe both come from the low bits, mix them with the high ones
+     * Time Complexity: O(k)
+     */
+    size_t hashKey(const Key& key) const
+    {
+        uint64_t h = (uint64_t)hash(key);
+        h ^= h >> 33;
+        h *= 0xFF51AFD7ED558CCDULL;
+        h ^= h >> 33;
+        return (size_t)h;
+    }
+
+    Stripe& stripeOf(size_t hashValue) const { return stripes[hashValue & stripeMask]; }
+
+    /**
+     * Lock-free traversal of a bucket
+     * @return the node of key, or nullptr
+     */
+    Node* findNode(const Table* table, size_t hashValue, const Key& key) const
+    {
+        Node* node = table->heads[hashValue & table->mask].load(std::memory_order_acquire);
+        for (; node != nullptr; node = node->next.load(std::memory_order_acquire))
+        {
+            if (node->hashValue == hashValue && keyEqual(node->key, key)) break;
+        }
+        return node;
+    }
+
+    /**
+     * Called with the stripe of key locked
+     * @return the link pointing at the node of key, or nullptr
+     */
+    std::atomic<Node*>* findLink(Table* table, size_t hashValue, const Key& key) const
+    {
+        std::atomic<Node*>* link = &table->heads[hashValue & table->mask];
+        for (Node* node = link->load(std::memory_order_relaxed); node != nullptr; node = link->load(std::memory_order_relaxed))
+        {
+            if (node->hashValue == hashValue && keyEqual(node->key, key)) return link;
+            link = &node->next;
+        }
+        return nullptr;
+    }
+
+    /**
+     * Read the node of key and apply f to it (or to nullptr) without locking
+     * f may run more than once, only the result of the last run is valid
+     */
+    template <typename F>
+    void read(const Key& key, F f) const
+    {
+        size_t hashValue = hashKey(key);
+        Stripe& stripe = stripeOf(hashValue);
+        EpochReclaimer::Guard guard;
+        for (int attempt = 0; attempt < OPTIMISTIC_READS; attempt++)
+        {
+            uint64_t version = stripe.version.load(std::memory_order_acquire);
+            if (version & 1)
+            {
+                std::this_thread::yield();
+                continue;
+            }
+            f(findNode(stripe.table.load(std::memory_order_acquire), hashValue, key));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (stripe.version.load(std::memory_order_relaxed) == version) return;
+        }
+        std::lock_guard<std::mutex> lock(stripe.lock);
+        f(findNode(stripe.table.load(std::memory_order_relaxed), hashValue, key));
+    }
+
+    /**
+     * Relink the nodes of a stripe into target, called with the stripe locked
+     * Time Complexity: O(bucketSize / stripeCount + number of nodes moved)
+     */
+    void migrateStripe(size_t index, Table* target)
+    {
+        Stripe& stripe = stripes[index];
+        std::lock_guard<std::mutex> lock(stripe.lock);
+        Table* source = stripe.table.load(std::memory_order_relaxed);
+        if (source == target) return;
+        uint64_t version = stripe.version.load(std::memory_order_relaxed);
+        stripe.version.store(version + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t bucket = index; bucket < source->size(); bucket += stripeCount)
+        {
+            Node* node = source->heads[bucket].load(std::memory_order_relaxed);
+            while (node != nullptr)
+            {
+                Node* next = node->next.load(std::memory_order_relaxed);
+                std::atomic<Node*>& head = target->heads[node->hashValue & target->mask];
+                node->next.store(head.load(std::memory_order_relaxed), std::memory_order_release);
+                head.store(node, std::memory_order_release);
+                node = next;
+            }
+            source->heads[bucket].store(nullptr, std::memory_order_release);
+        }
+        stripe.table.store(target, std::memory_order_release);
+        stripe.version.store(version + 2, std::memory_order_release);
+    }
+
+    /**
+     * Migrate up to count stripes of the resize in progress, if any
+     */
+    void helpResize(size_t count)
+    {
+        if (resize.load(std::memory_order_acquire) == nullptr) return;
+        EpochReclaimer::Guard guard;
+        Resize* r = resize.load(std::memory_order_acquire);
+        if (r == nullptr) return;
+        for (; count > 0; count--)
+        {
+            size_t index = r->nextStripe.fetch_add(1);
+            if (index >= stripeCount) return;
+            migrateStripe(index, r->target);
+            if (r->migrated.fetch_add(1) + 1 == stripeCount)
+            {
+                Table* old = current.exchange(r->target);
+                resize.store(nullptr, std::memory_order_release);
+                EpochReclaimer::instance().retire(old, deleteTable);
+                EpochReclaimer::instance().retire(r, deleteResize);
+            }
+        }
+    }
+
+    /**
+     * Called after an insertion into stripe, without holding its lock
+     * Doubles the table when the stripe exceeds its share of the maximum load
+     */
+    void grow(Stripe& stripe)
+    {
+        Table* table = stripe.table.load(std::memory_order_acquire);
+        double stripeBuckets = (double)(table->size() / stripeCount);
+        if ((double)stripe.count.load(std::memory_order_relaxed) <= maxLoadFactor * stripeBuckets) return;
+        {
+            std::unique_lock<std::mutex> lock(resizeLock, std::try_to_lock);
+            if (!lock.owns_lock()) return;
+            if (resize.load() != nullptr || current.load() != table) return;
+            resize.store(new Resize(new Table(table->size() * 2)), std::memory_order_release);
+        }
+        helpResize(stripeCount);
+    }
+
+public:
+    /**
+     * @param bucketSize initial number of buckets, rounded up to a power of 2 of at least stripeCount
+     * @param stripeCount number of writer locks, rounded up to a power of 2
+     */
+    explicit ConcurrentHashTable(size_t bucketSize = 0, size_t stripeCount = DEFAULT_STRIPE_COUNT)
+        : stripeCount(roundUpPowerOfTwo(std::max<size_t>(stripeCount, 1))), stripeMask(this->stripeCount - 1),
+          stripes(new Stripe[this->stripeCount]), maxLoadFactor(DEFAULT_LOAD_FACTOR), hash(Hash()), keyEqual(KeyEqual())
+    {
+        Table* table = new Table(roundUpPowerOfTwo(std::max(bucketSize, this->stripeCount)));
+        current.store(table);
+        for (size_t i = 0; i < this->stripeCount; i++)
+        {
+            stripes[i].table.store(table, std::memory_order_relaxed);
+        }
+    }
+
+    ConcurrentHashTable(const ConcurrentHashTable&) = delete;
+    ConcurrentHashTable& operator=(const ConcurrentHashTable&) = delete;
+
+    /**
+     * No other thread may use the table any more
+     */
+    ~ConcurrentHashTable()
+    {
+        Resize* r = resize.load();
+        Table* tables[2] = {current.load(), r != nullptr ? r->target : nullptr};
+        for (Table* table : tables)
+        {
+            if (table == nullptr) continue;
+            for (size_t i = 0; i < table->size(); i++)
+            {
+                Node* node = table->heads[i].load(std::memory_order_relaxed);
+                while (node != nullptr)
+                {
+                    Node* next = node->next.load(std::memory_order_relaxed);
+                    delete node;
+                    node = next;
+                }
+            }
+            delete table;
+        }
+        delete r;
+    }
+
+    /**
+     * Lock-free lookup
+     * Time Complexity: O(k)
+     * @param key
+     * @param value set to a copy of the value of key, if it exists
+     * @return whether the key exists
+     */
+    bool find(const Key& key, Value& value) const
+    {
+        bool found = false;
+        read(key, [&](const Node* node) {
+            found = node != nullptr;
+            if (found) value = node->value;
+        });
+        return found;
+    }
+
+    /**
+     * Lock-free membership test
+     * Time Complexity: O(k)
+     */
+    bool contains(const Key& key) const
+    {
+        bool found = false;
+        read(key, [&](const Node* node) { found = node != nullptr; });
+        return found;
+    }
+
+    /**
+     * Insert <key, value>, or replace the value if the key already exists
+     * Time Complexity: Amortized O(k)
+     * @return whether insertion took place (return false if the key already exists)
+     */
+    bool insertOrAssign(const Key& key, const Value& value)
+    {
+        helpResize(HELP_STRIPES);
+        size_t hashValue = hashKey(key);
+        Stripe& stripe = stripeOf(hashValue);
+        {
+            std::lock_guard<std::mutex> lock(stripe.lock);
+            Table* table = stripe.table.load(std::memory_order_relaxed);
+            std::atomic<Node*>* link = findLink(table, hashValue, key);
+            if (link != nullptr)
+            {
+                Node* old = link->load(std::memory_order_relaxed);
+                link->store(new Node(hashValue, key, value, old->next.load(std::memory_order_relaxed)),
+                            std::memory_order_release);
+                EpochReclaimer::instance().retire(old, deleteNode);
+                return false;
+            }
+            std::atomic<Node*>& head = table->heads[hashValue & table->mask];
+            head.store(new Node(hashValue, key, value, head.load(std::memory_order_relaxed)), std::memory_order_release);
+            stripe.count.fetch_add(1, std::memory_order_relaxed);
+        }
+        grow(stripe);
+        return true;
+    }
+
+    /**
+     * Erase the key if it exists
+     * Time Complexity: O(k)
+     * @return whether the key exists
+     */
+    bool erase(const Key& key)
+    {
+        helpResize(HELP_STRIPES);
+        size_t hashValue = hashKey(key);
+        Stripe& stripe = stripeOf(hashValue);
+        std::lock_guard<std::mutex> lock(stripe.lock);
+        std::atomic<Node*>* link = findLink(stripe.table.load(std::memory_order_relaxed), hashValue, key);
+        if (link == nullptr) return false;
+        Node* old = link->load(std::memory_order_relaxed);
+        link->store(old->next.load(std::memory_order_relaxed), std::memory_order_release);
+        stripe.count.fetch_sub(1, std::memory_order_relaxed);
+        EpochReclaimer::instance().retire(old, deleteNode);
+        return true;
+    }
+
+    /**
+     * Return the value of key, inserting compute(key) first if the key does not exist
+     * compute runs at most once per inserted key, with the stripe of key locked, so it must
+     * not use this table
+     * Time Complexity: Amortized O(k) plus compute
+     * @return a copy of the value of key
+     */
+    template <typename Compute>
+    Value computeIfAbsent(const Key& key, Compute compute)
+    {
+        Value value;
+        if (find(key, value)) return value;
+        helpResize(HELP_STRIPES);
+        size_t hashValue = hashKey(key);
+        Stripe& stripe = stripeOf(hashValue);
+        {
+            std::lock_guard<std::mutex> lock(stripe.lock);
+            Table* table = stripe.table.load(std::memory_order_relaxed);
+            std::atomic<Node*>* link = findLink(table, hashValue, key);
+            if (link != nullptr) return link->load(std::memory_order_relaxed)->value;
+            value = compute(key);
+            std::atomic<Node*>& head = table->heads[hashValue & table->mask];
+            head.store(new Node(hashValue, key, value, head.load(std::memory_order_relaxed)), std::memory_order_release);
+            stripe.count.fetch_add(1, std::memory_order_relaxed);
+        }
+        grow(stripe);
+        return value;
+    }
+
+    /**
+     * @return the number of elements, exact only when no writer is running
+     */
+    size_t size() const
+    {
+        size_t result = 0;
+        for (size_t i = 0; i < stripeCount; i++)
+        {
+            result += stripes[i].count.load(std::memory_order_relaxed);
+        }
+        return result;
+    }
+
+    /**
+     * @return the number of buckets of the newest complete table
+     */
+    size_t bucketSize() const { return current.load()->size(); }
+
+    size_t getStripeCount() const { return stripeCount; }
+
+    bool isRehashing() const { return resize.load() != nullptr; }
+
+    double getMaxLoadFactor() const { return maxLoadFactor; }
+
+    /**
+     * Set the max load factor, before the table is shared
+     * @throw std::range_error if the load factor is too small
+     */
+    void setMaxLoadFactor(double loadFactor)
+    {
+        if (loadFactor <= 1e-9)
+        {
+            throw std::range_error("invalid load factor!");
+        }
+        maxLoadFactor = loadFactor;
+    }
+};
+
+#endif //VE281P2_CONCURRENT_HASHTABLE_HPP
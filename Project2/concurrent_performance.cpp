@@ -0,0 +1,127 @@
+#include "concurrent_hashtable.hpp"
+#include "hashtable.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+using namespace std;
+
+// Usage: ./concurrent_performance [total_ops=4000000] [key_range=1000000]
+// Threads run from 1 to 64, sharing total_ops operations on one table prefilled to half of key_range
+// Output (CSV): table,mix,threads,seconds,mops (million operations per second)
+
+struct mix
+{
+    string name;
+    unsigned find_percent;
+    unsigned insert_percent; // the rest are erases
+};
+
+/**
+ * The baseline: HashTable behind one global mutex
+ */
+class locked_table
+{
+private:
+    HashTable<long, long> table;
+    mutex lock;
+
+public:
+    bool find(long key, long &value)
+    {
+        lock_guard<mutex> guard(lock);
+        auto it = table.find(key);
+        if (it == table.end()) return false;
+        value = it->second;
+        return true;
+    }
+    void insertOrAssign(long key, long value)
+    {
+        lock_guard<mutex> guard(lock);
+        table.insert(key, value);
+    }
+    void erase(long key)
+    {
+        lock_guard<mutex> guard(lock);
+        table.erase(key);
+    }
+};
+
+template <typename Table>
+double run_threads(Table &table, const mix &m, unsigned threads, size_t total_ops, long key_range)
+{
+    vector<thread> workers;
+    size_t ops = total_ops / threads;
+    auto start = chrono::steady_clock::now();
+    for (unsigned id = 0; id < threads; id++)
+    {
+        workers.emplace_back([&table, &m, ops, key_range, id]() {
+            mt19937_64 gen(id + 1);
+            uniform_int_distribution<long> keys(0, key_range - 1);
+            uniform_int_distribution<unsigned> percent(0, 99);
+            long value, found = 0;
+            for (size_t i = 0; i < ops; i++)
+            {
+                long key = keys(gen);
+                unsigned p = percent(gen);
+                if (p < m.find_percent)
+                {
+                    found += table.find(key, value);
+                }
+                else if (p < m.find_percent + m.insert_percent)
+                {
+                    table.insertOrAssign(key, (long)i);
+                }
+                else
+                {
+                    table.erase(key);
+                }
+            }
+            if (found < 0) printf("unreachable\n");
+        });
+    }
+    for (auto &w : workers)
+    {
+        w.join();
+    }
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+template <typename Table>
+void run(const string &name, const mix &m, unsigned threads, size_t total_ops, long key_range)
+{
+    Table table;
+    for (long k = 0; k < key_range; k += 2)
+    {
+        table.insertOrAssign(k, k);
+    }
+    double seconds = run_threads(table, m, threads, total_ops, key_range);
+    size_t ops = total_ops / threads * threads;
+    printf("%s,%s,%u,%.4f,%.3f\n", name.c_str(), m.name.c_str(), threads, seconds, (double)ops / seconds / 1e6);
+    fflush(stdout);
+}
+
+int main(int argc, char *argv[])
+{
+    size_t total_ops = argc > 1 ? strtoul(argv[1], nullptr, 10) : 4000000;
+    long key_range = argc > 2 ? strtol(argv[2], nullptr, 10) : 1000000;
+    const mix mixes[] = {
+        {"read_heavy", 90, 5},
+        {"balanced", 50, 25},
+    };
+    printf("table,mix,threads,seconds,mops\n");
+    for (auto &m : mixes)
+    {
+        for (unsigned threads = 1; threads <= 64; threads *= 2)
+        {
+            run<locked_table>("global_mutex", m, threads, total_ops, key_range);
+            run<ConcurrentHashTable<long, long>>("concurrent", m, threads, total_ops, key_range);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,408 @@
+#ifndef VE281P2_COW_HASHTABLE_HPP
+#define VE281P2_COW_HASHTABLE_HPP
+#include "bucket_policy.hpp"
+#include <algorithm>
+#include <atomic>
+#include <forward_list>
+#include <functional>
+#include <math.h>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+/**
+ * A chained hashtable with copy-on-write versions, for a writer publishing its table to readers
+ * The buckets are grouped in chunks of CHUNK_BUCKETS, and a version is a vector of shared chunks
+ * - snapshot() returns an immutable view of the current version in O(1)
+ * - while a snapshot (or a copy of the table) shares the version, the first write copies the vector
+ *   of chunk pointers, and each write copies the chunk of its bucket unless it is already private,
+ *   so the writer copies the buckets it modifies and nothing else
+ * - a resize builds a new version, moving the nodes of chunks no snapshot shares
+ * A table is used by one writer thread, snapshots can be read and destroyed by any thread
+ * @tparam Key          key type
+ * @tparam Value        data type
+ * @tparam Hash         function object, return the hash value of a key
+ * @tparam KeyEqual     function object, return whether two keys are the same
+ */
+template <
+    typename Key, typename Value,
+    typename Hash = std::hash<Key>,
+    typename KeyEqual = std::equal_to<Key>
+>
+class CowHashTable
+{
+public:
+    typedef std::pair<const Key, Value> HashNode;
+
+protected:
+    static constexpr double DEFAULT_LOAD_FACTOR = 0.5; // default maximum load factor is 0.5
+    static constexpr size_t CHUNK_BUCKETS = 64;        // buckets copied together by a write
+
+    struct StoredNode
+    {
+        size_t hashValue;
+        HashNode node;
+
+        template <typename... Args>
+        StoredNode(size_t hashValue, Args&&... args) :
+            hashValue(hashValue), node(std::forward<Args>(args)...) {}
+    };
+
+    typedef std::forward_list<StoredNode> HashNodeList;
+
+    struct Chunk
+    {
+        HashNodeList buckets[CHUNK_BUCKETS];
+    };
+
+    struct Version
+    {
+        std::vector<std::shared_ptr<Chunk>> chunks;
+        PowerOfTwoBucketPolicy policy;
+        size_t bucketCount = 0;
+        size_t tableSize = 0;
+
+        explicit Version(size_t bucketCount) : chunks(bucketCount / CHUNK_BUCKETS), bucketCount(bucketCount)
+        {
+            for (auto& chunk : chunks)
+            {
+                chunk = std::make_shared<Chunk>();
+            }
+            policy.reset(bucketCount);
+        }
+
+        const HashNodeList& bucket(size_t index) const
+        {
+            return chunks[index / CHUNK_BUCKETS]->buckets[index % CHUNK_BUCKETS];
+        }
+
+        /**
+         * Time Complexity: O(k)
+         * @return the node of key, or nullptr
+         */
+        template <typename Equal>
+        const HashNode* find(const Key& key, size_t hashValue, const Equal& keyEqual) const
+        {
+            for (const StoredNode& stored : bucket(policy.bucket(hashValue)))
+            {
+                if (stored.hashValue == hashValue && keyEqual(stored.node.first, key))
+                {
+                    return &stored.node;
+                }
+            }
+            return nullptr;
+        }
+    };
+
+    std::shared_ptr<Version> version;
+    double maxLoadFactor; // maximum load factor
+    Hash hash;            // hash function instance
+    KeyEqual keyEqual;    // key equal function instance
+
+    /**
+     * Whether nothing else holds p, so it can be modified in place
+     * Only the writer adds owners, and the last release by another thread (acq_rel)
+     * is ordered before the writes that follow by the fence
+     */
+    template <typename T>
+    static bool exclusive(const std::shared_ptr<T>& p)
+    {
+        if (p.use_count() != 1) return false;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return true;
+    }
+
+    /**
+     * The version, copied first (its chunk pointers only) if it is shared
+     * Time Complexity: O(1), O(bucketSize / CHUNK_BUCKETS) for the first write after a snapshot
+     */
+    Version& writableVersion()
+    {
+        if (!exclusive(version))
+        {
+            version = std::make_shared<Version>(*version);
+        }
+        return *version;
+    }
+
+    /**
+     * The list of a bucket, its chunk copied first if it is shared
+     * Time Complexity: O(1), O(nodes of the chunk) if the chunk is copied
+     */
+    HashNodeList& writableBucket(size_t index)
+    {
+        std::shared_ptr<Chunk>& chunk = writableVersion().chunks[index / CHUNK_BUCKETS];
+        if (!exclusive(chunk))
+        {
+            chunk = std::make_shared<Chunk>(*chunk);
+        }
+        return chunk->buckets[index % CHUNK_BUCKETS];
+    }
+
+    /**
+     * @return the before iterator of key in list, or list.end()
+     */
+    typename HashNodeList::iterator findBefore(HashNodeList& list, const Key& key, size_t hashValue) const
+    {
+        for (auto listIt = list.before_begin(), nextIt = list.begin(); nextIt != list.end(); listIt = nextIt++)
+        {
+            if (nextIt->hashValue == hashValue && keyEqual(nextIt->node.first, key))
+            {
+                return listIt;
+            }
+        }
+        return list.end();
+    }
+
+    size_t findMinimumBucketSize(size_t bucketSize) const
+    {
+        size_t thisMaxLoad = (size_t)floor((double)version->tableSize / maxLoadFactor);
+        return PowerOfTwoBucketPolicy::roundUp(std::max({bucketSize, thisMaxLoad + 1, CHUNK_BUCKETS}));
+    }
+
+    /**
+     * Link a new node of key, known to be absent, then grow if needed
+     */
+    template <typename V>
+    Value& insertAbsent(const Key& key, size_t hashValue, V&& value)
+    {
+        HashNodeList& list = writableBucket(version->policy.bucket(hashValue));
+        list.emplace_front(hashValue, key, std::forward<V>(value));
+        Value* result = &list.front().node.second;
+        if ((double)++version->tableSize >= maxLoadFactor * (double)version->bucketCount)
+        {
+            rehash(version->bucketCount);
+            // rehash copies the nodes of shared chunks
+            result = const_cast<Value*>(&version->find(key, hashValue, keyEqual)->second);
+        }
+        return *result;
+    }
+
+public:
+    /**
+     * An immutable view of the table at the time of CowHashTable::snapshot, safe to read from any thread
+     */
+    class Snapshot
+    {
+    private:
+        std::shared_ptr<const Version> version;
+        Hash hash;
+        KeyEqual keyEqual;
+
+        Snapshot(std::shared_ptr<const Version> version, const Hash& hash, const KeyEqual& keyEqual) :
+            version(std::move(version)), hash(hash), keyEqual(keyEqual) {}
+
+    public:
+        friend class CowHashTable;
+
+        /**
+         * Time Complexity: O(k)
+         * @return a pointer to the value of key, valid as long as the snapshot, or nullptr
+         */
+        const Value* find(const Key& key) const
+        {
+            const HashNode* node = version->find(key, hash(key), keyEqual);
+            return node ? &node->second : nullptr;
+        }
+
+        bool contains(const Key& key) const { return find(key) != nullptr; }
+
+        size_t size() const { return version->tableSize; }
+
+        /**
+         * Call f(node) on every node, in an unspecified order
+         * Time Complexity: O(n + bucketSize)
+         */
+        template <typename F>
+        void forEach(F f) const
+        {
+            for (size_t i = 0; i < version->bucketCount; i++)
+            {
+                for (const StoredNode& stored : version->bucket(i))
+                {
+                    f(stored.node);
+                }
+            }
+        }
+    };
+
+    CowHashTable() : version(std::make_shared<Version>(CHUNK_BUCKETS)), maxLoadFactor(DEFAULT_LOAD_FACTOR),
+        hash(Hash()), keyEqual(KeyEqual()) {}
+
+    explicit CowHashTable(size_t bucketSize) : CowHashTable()
+    {
+        rehash(bucketSize);
+    }
+
+    /**
+     * A copy shares every chunk until one of the tables writes to it
+     * Time Complexity: O(1)
+     */
+    CowHashTable(const CowHashTable& that) = default;
+
+    CowHashTable& operator=(const CowHashTable& that) = default;
+
+    /**
+     * Take an immutable view of the table, later writes to the table are not seen by it
+     * Time Complexity: O(1)
+     */
+    Snapshot snapshot() const
+    {
+        return Snapshot(version, hash, keyEqual);
+    }
+
+    /**
+     * Time Complexity: O(k)
+     * @return a pointer to the value of key, valid until the next write, or nullptr
+     */
+    const Value* find(const Key& key) const
+    {
+        const HashNode* node = version->find(key, hash(key), keyEqual);
+        return node ? &node->second : nullptr;
+    }
+
+    bool contains(const Key& key) const { return find(key) != nullptr; }
+
+    /**
+     * Insert <key, value> into the hashtable
+     * If the key already exists, overwrite its value
+     * Time Complexity: Amortized O(k), plus the copy of a shared chunk
+     * @return whether insertion took place (return false if the key already exists)
+     */
+    bool insert(const Key& key, const Value& value)
+    {
+        size_t hashValue = hash(key);
+        if (version->find(key, hashValue, keyEqual) == nullptr)
+        {
+            insertAbsent(key, hashValue, value);
+            return true;
+        }
+        HashNodeList& list = writableBucket(version->policy.bucket(hashValue));
+        std::next(findBefore(list, key, hashValue))->node.second = value;
+        return false;
+    }
+
+    /**
+     * Erase the key if it exists in the hashtable, otherwise, do nothing (and copy nothing)
+     * Time Complexity: O(k), plus the copy of a shared chunk
+     * @return whether the key exists
+     */
+    bool erase(const Key& key)
+    {
+        size_t hashValue = hash(key);
+        if (version->find(key, hashValue, keyEqual) == nullptr)
+        {
+            return false;
+        }
+        HashNodeList& list = writableBucket(version->policy.bucket(hashValue));
+        list.erase_after(findBefore(list, key, hashValue));
+        version->tableSize--;
+        return true;
+    }
+
+    /**
+     * Get the reference of value by key in the hashtable, valid until the next write
+     * If the key doesn't exist, create it first (use default constructor of Value)
+     * The chunk of the key is made private, even if the value is only read
+     * Time Complexity: Amortized O(k), plus the copy of a shared chunk
+     */
+    Value& operator[](const Key& key)
+    {
+        size_t hashValue = hash(key);
+        if (version->find(key, hashValue, keyEqual) == nullptr)
+        {
+            return insertAbsent(key, hashValue, Value());
+        }
+        HashNodeList& list = writableBucket(version->policy.bucket(hashValue));
+        return std::next(findBefore(list, key, hashValue))->node.second;
+    }
+
+    /**
+     * Rehash the hashtable into a new version of at least bucketSize buckets, see HashTable::rehash
+     * Nodes of chunks no snapshot shares are relinked, the others copied
+     * Time Complexity: O(nk + bucketSize)
+     */
+    void rehash(size_t bucketSize)
+    {
+        size_t newBucketSize = findMinimumBucketSize(bucketSize);
+        if (newBucketSize == version->bucketCount) return;
+        auto next = std::make_shared<Version>(newBucketSize);
+        next->tableSize = version->tableSize;
+        bool versionExclusive = exclusive(version);
+        for (auto& chunk : version->chunks)
+        {
+            bool move = versionExclusive && exclusive(chunk);
+            for (HashNodeList& from : chunk->buckets)
+            {
+                auto target = [&](const StoredNode& stored) -> HashNodeList& {
+                    size_t index = next->policy.bucket(stored.hashValue);
+                    return next->chunks[index / CHUNK_BUCKETS]->buckets[index % CHUNK_BUCKETS];
+                };
+                if (move)
+                {
+                    while (!from.empty())
+                    {
+                        HashNodeList& to = target(from.front());
+                        to.splice_after(to.before_begin(), from, from.before_begin());
+                    }
+                }
+                else
+                {
+                    for (const StoredNode& stored : from)
+                    {
+                        target(stored).push_front(stored);
+                    }
+                }
+            }
+        }
+        version = std::move(next);
+    }
+
+    /**
+     * Call f(node) on every node, in an unspecified order, f must not modify the table
+     * Time Complexity: O(n + bucketSize)
+     */
+    template <typename F>
+    void forEach(F f) const
+    {
+        snapshot().forEach(f);
+    }
+
+    /**
+     * @return the number of elements in the hashtable
+     */
+    size_t size() const { return version->tableSize; }
+
+    /**
+     * @return the number of buckets in the hashtable
+     */
+    size_t bucketSize() const { return version->bucketCount; }
+
+    /**
+     * @return the current load factor of the hashtable
+     */
+    double loadFactor() const { return (double)version->tableSize / (double)version->bucketCount; }
+
+    /**
+     * @return the maximum load factor of the hashtable
+     */
+    double getMaxLoadFactor() const { return maxLoadFactor; }
+
+    /**
+     * Set the max load factor
+     * @throw std::range_error if the load factor is too small
+     * @param loadFactor
+     */
+    void setMaxLoadFactor(double loadFactor)
+    {
+        if (loadFactor <= 1e-9)
+        {
+            throw std::range_error("invalid load factor!");
+        }
+        maxLoadFactor = loadFactor;
+        rehash(version->bucketCount);
+    }
+};
+
+#endif //VE281P2_COW_HASHTABLE_HPP
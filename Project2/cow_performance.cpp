@@ -0,0 +1,106 @@
+#include "cow_hashtable.hpp"
+#include "hashtable.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+using namespace std;
+
+// Usage: ./cow_performance [max_exponent=6] [writes=1000] [seed]
+// For n from 10^4 to 10^max_exponent int64 keys, a writer publishes 20 versions to readers,
+// each after updating `writes` random keys:
+//   HashTable copies the whole table for every version,
+//   CowHashTable takes a snapshot and copies only the chunks of buckets written after it
+// Output (CSV): table,n,writes,publish,release,writes_after_publish,find
+// (microseconds per version to publish it, to free the previous one and for the writes before it,
+//  nanoseconds per find in the last version)
+
+constexpr size_t VERSIONS = 20;
+
+double us_since(chrono::steady_clock::time_point start)
+{
+    chrono::duration<double, micro> elapsed = chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+void run_hashtable(const vector<long> &keys, size_t writes, mt19937_64 &gen)
+{
+    HashTable<long, long> table;
+    for (long k : keys) table.insert(k, 0);
+    double publish = 0, release = 0, update = 0;
+    long checksum = 0;
+    HashTable<long, long> published(table);
+    for (size_t v = 0; v < VERSIONS; v++)
+    {
+        auto start = chrono::steady_clock::now();
+        for (size_t i = 0; i < writes; i++)
+        {
+            table[keys[gen() % keys.size()]] = (long)v;
+        }
+        update += us_since(start);
+        start = chrono::steady_clock::now();
+        HashTable<long, long> next(table);
+        publish += us_since(start);
+        start = chrono::steady_clock::now();
+        published = std::move(next);
+        release += us_since(start);
+        checksum += (long)published.size();
+    }
+    auto start = chrono::steady_clock::now();
+    for (long k : keys) checksum += published.find(k)->second;
+    double find = us_since(start) * 1000 / (double)keys.size();
+    printf("HashTable,%zu,%zu,%.2f,%.2f,%.2f,%.2f\n", keys.size(), writes, publish / VERSIONS, release / VERSIONS, update / VERSIONS, find);
+    fprintf(stderr, "%ld\n", checksum);
+}
+
+void run_cow(const vector<long> &keys, size_t writes, mt19937_64 &gen)
+{
+    CowHashTable<long, long> table;
+    for (long k : keys) table.insert(k, 0);
+    double publish = 0, release = 0, update = 0;
+    long checksum = 0;
+    // the previous version stays alive while the writer updates, as it would with readers
+    CowHashTable<long, long>::Snapshot published = table.snapshot();
+    for (size_t v = 0; v < VERSIONS; v++)
+    {
+        auto start = chrono::steady_clock::now();
+        for (size_t i = 0; i < writes; i++)
+        {
+            table[keys[gen() % keys.size()]] = (long)v;
+        }
+        update += us_since(start);
+        start = chrono::steady_clock::now();
+        CowHashTable<long, long>::Snapshot next = table.snapshot();
+        publish += us_since(start);
+        start = chrono::steady_clock::now();
+        published = std::move(next);
+        release += us_since(start);
+        checksum += (long)published.size();
+    }
+    auto start = chrono::steady_clock::now();
+    for (long k : keys) checksum += *published.find(k);
+    double find = us_since(start) * 1000 / (double)keys.size();
+    printf("CowHashTable,%zu,%zu,%.2f,%.2f,%.2f,%.2f\n", keys.size(), writes, publish / VERSIONS, release / VERSIONS, update / VERSIONS, find);
+    fprintf(stderr, "%ld\n", checksum);
+}
+
+int main(int argc, char *argv[])
+{
+    int max_exponent = argc > 1 ? atoi(argv[1]) : 6;
+    size_t writes = argc > 2 ? strtoul(argv[2], nullptr, 10) : 1000;
+    unsigned long seed = argc > 3 ? strtoul(argv[3], nullptr, 10) : 281;
+    mt19937_64 gen(seed);
+    printf("table,n,writes,publish,release,writes_after_publish,find\n");
+    for (int e = 4; e <= max_exponent; e++)
+    {
+        size_t n = 1;
+        for (int i = 0; i < e; i++) n *= 10;
+        vector<long> keys(n);
+        for (auto &k : keys) k = (long)gen();
+        run_hashtable(keys, writes, gen);
+        run_cow(keys, writes, gen);
+        fflush(stdout);
+    }
+    return 0;
+}
@@ -0,0 +1,780 @@
+#ifndef VE281P2_CUCKOO_HASHTABLE_HPP
+#define VE281P2_CUCKOO_HASHTABLE_HPP
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+/**
+ * A bucketized cuckoo hashtable: every key lives in one of its two candidate buckets
+ * of SLOTS slots each (or in a small stash), so a lookup reads at most two buckets
+ * Buckets are 64-byte aligned blocks of SLOTS tag bytes followed by SLOTS nodes,
+ * one cache line each when SLOTS nodes fit in 60 bytes (e.g. <int, int> or <long, int> keys),
+ * two otherwise; the stash is only read while it is not empty
+ * An insertion into two full buckets searches breadth-first for a short path of moves that
+ * frees a slot in one of them. If there is none, the node goes to the stash, and when the
+ * stash is full too, the table doubles, unless it is less than half as full as allowed:
+ * then the keys crowding those buckets share most of their hash bits, doubling would not
+ * separate them, and the stash grows instead (lookups of these keys scan it, like a chain)
+ * Same public API as HashTable
+ * @tparam Key          key type
+ * @tparam Value        data type
+ * @tparam Hash         function object, return the hash value of a key
+ * @tparam KeyEqual     function object, return whether two keys are the same
+ */
+template <
+    typename Key, typename Value,
+    typename Hash = std::hash<Key>,
+    typename KeyEqual = std::equal_to<Key>
+>
+class CuckooHashTable
+{
+public:
+    /**
+     * What an iterator refers to: the key can only be read, the value can also be written
+     * Slots hold a mutable pair<Key, Value> so that a rehash can move the keys
+     */
+    struct Reference
+    {
+        const Key& first;
+        Value& second;
+
+        Reference* operator->() { return this; }
+    };
+
+protected:
+    typedef std::pair<Key, Value> HashNode;
+
+    static constexpr size_t SLOTS = 4;                    // slots per bucket
+    static constexpr size_t MIN_BUCKET_COUNT = 2;
+    static constexpr size_t MAX_SEARCH_BUCKETS = 256;     // buckets visited by one breadth-first search
+    static constexpr double DEFAULT_LOAD_FACTOR = 0.95;   // default maximum load factor
+    static constexpr uint8_t TAG_EMPTY = 0;
+
+    struct alignas(64) Bucket
+    {
+        uint8_t tags[SLOTS];  // TAG_EMPTY, or some bits of the hash of the node in the slot
+        typename std::aligned_storage<sizeof(HashNode), alignof(HashNode)>::type slots[SLOTS];
+    };
+
+public:
+    /**
+     * A single directional iterator for the hashtable
+     * Slots are numbered bucket * SLOTS + slot, the stash is buckets bucketCount and on
+     */
+    class Iterator
+    {
+    private:
+        CuckooHashTable* hashTable;
+        size_t index;          // slot index, past the stash for the end iterator
+        size_t hashValue = 0;  // hash of the key a failed find was looking for
+        bool endFlag = false;  // whether it is an end iterator
+
+        /**
+         * Increment the iterator
+         * Time complexity: Amortized O(1)
+         */
+        void increment()
+        {
+            size_t last = hashTable->endIndex();
+            while (++index < last)
+            {
+                if (hashTable->tagAt(index) != TAG_EMPTY) return;
+            }
+            endFlag = true;
+        }
+
+        Iterator(CuckooHashTable* hashTable, size_t index) : hashTable(hashTable), index(index)
+        {
+            endFlag = index >= hashTable->endIndex();
+        }
+
+    public:
+        friend class CuckooHashTable;
+
+        Iterator() = delete;
+
+        Iterator(const Iterator&) = default;
+
+        Iterator& operator=(const Iterator&) = default;
+
+        Iterator& operator++()
+        {
+            increment();
+            return *this;
+        }
+
+        Iterator operator++(int)
+        {
+            Iterator temp = *this;
+            increment();
+            return temp;
+        }
+
+        bool operator==(const Iterator& that) const
+        {
+            if (endFlag && that.endFlag)
+                return true;
+            return !endFlag && !that.endFlag && index == that.index;
+        }
+
+        bool operator!=(const Iterator& that) const
+        {
+            return !(*this == that);
+        }
+
+        Reference operator->()
+        {
+            return **this;
+        }
+
+        Reference operator*()
+        {
+            HashNode& node = *hashTable->nodeAt(index);
+            return {node.first, node.second};
+        }
+    };
+
+protected:
+    Bucket* buckets = nullptr;  // bucketCount buckets, then the stashBuckets buckets of the stash
+    size_t bucketCount = 0;     // a power of 2
+    size_t stashBuckets = 1;    // grows only when keys with nearly equal hashes overflow their buckets
+    size_t tableSize = 0;       // number of elements, including the stash
+    size_t stashSize = 0;       // number of elements in the stash
+    double maxLoadFactor;       // maximum load factor
+    double achievableLoadFactor = 0; // load factor when an insertion last found no room
+    Hash hash;                  // hash function instance
+    KeyEqual keyEqual;          // key equal function instance
+
+    /**
+     * One step of a breadth-first search: the node in slot of bucket parent can move to bucket
+     */
+    struct SearchStep
+    {
+        size_t bucket;
+        long parent; // -1 for the two candidate buckets of the new key
+        size_t slot;
+    };
+
+    /**
+     * Mix the user hash so that both bucket indices and the tag depend on every bit
+     * (std::hash of integers is the identity)
+     */
+    inline size_t hashKey(const Key& key) const
+    {
+        uint64_t h = (uint64_t)hash(key);
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= h >> 33;
+        return (size_t)h;
+    }
+
+    static uint8_t tagOf(size_t hashValue)
+    {
+        uint8_t tag = (uint8_t)(hashValue >> 56);
+        return tag == TAG_EMPTY ? 1 : tag;
+    }
+
+    size_t firstBucket(size_t hashValue) const { return hashValue & (bucketCount - 1); }
+
+    /**
+     * The second bucket comes from the high half of the hash, and always differs from the first
+     */
+    size_t secondBucket(size_t hashValue) const
+    {
+        size_t second = ((hashValue >> 32) | (hashValue << 32)) & (bucketCount - 1);
+        return second == firstBucket(hashValue) ? second ^ 1 : second;
+    }
+
+    HashNode* node(size_t bucket, size_t slot) const
+    {
+        return std::launder(reinterpret_cast<HashNode*>(&buckets[bucket].slots[slot]));
+    }
+
+    HashNode* nodeAt(size_t index) const { return node(index / SLOTS, index % SLOTS); }
+
+    uint8_t tagAt(size_t index) const { return buckets[index / SLOTS].tags[index % SLOTS]; }
+
+    size_t endIndex() const { return (bucketCount + stashBuckets) * SLOTS; }
+
+    size_t findEmptySlot(size_t bucket) const
+    {
+        for (size_t i = 0; i < SLOTS; i++)
+        {
+            if (buckets[bucket].tags[i] == TAG_EMPTY) return i;
+        }
+        return SLOTS;
+    }
+
+    /**
+     * Time Complexity: O(k)
+     * @return the slot index of key in bucket, or SIZE_MAX
+     */
+    size_t findInBucket(size_t bucket, uint8_t tag, const Key& key) const
+    {
+        const Bucket& b = buckets[bucket];
+        for (size_t i = 0; i < SLOTS; i++)
+        {
+            if (b.tags[i] == tag && keyEqual(node(bucket, i)->first, key))
+            {
+                return bucket * SLOTS + i;
+            }
+        }
+        return SIZE_MAX;
+    }
+
+    /**
+     * Time Complexity: O(stashBuckets * SLOTS * k)
+     * @return the slot index of key in the stash, or SIZE_MAX
+     */
+    size_t findInStash(uint8_t tag, const Key& key) const
+    {
+        for (size_t b = bucketCount; b < bucketCount + stashBuckets; b++)
+        {
+            size_t index = findInBucket(b, tag, key);
+            if (index != SIZE_MAX) return index;
+        }
+        return SIZE_MAX;
+    }
+
+    /**
+     * @return the index of an empty slot of the stash, or SIZE_MAX
+     */
+    size_t findEmptyStashSlot() const
+    {
+        for (size_t b = bucketCount; b < bucketCount + stashBuckets; b++)
+        {
+            size_t slot = findEmptySlot(b);
+            if (slot != SLOTS) return b * SLOTS + slot;
+        }
+        return SIZE_MAX;
+    }
+
+    template <typename K, typename V>
+    void construct(size_t bucket, size_t slot, uint8_t tag, K&& key, V&& value)
+    {
+        new (&buckets[bucket].slots[slot]) HashNode(std::forward<K>(key), std::forward<V>(value));
+        buckets[bucket].tags[slot] = tag;
+    }
+
+    void destroy(size_t bucket, size_t slot)
+    {
+        node(bucket, slot)->~HashNode();
+        buckets[bucket].tags[slot] = TAG_EMPTY;
+    }
+
+    /**
+     * Move the node of slot from to the empty slot to
+     */
+    void moveNode(size_t fromBucket, size_t fromSlot, size_t toBucket, size_t toSlot)
+    {
+        HashNode* from = node(fromBucket, fromSlot);
+        construct(toBucket, toSlot, buckets[fromBucket].tags[fromSlot],
+                  std::move(from->first), std::move(from->second));
+        destroy(fromBucket, fromSlot);
+    }
+
+    void allocate(size_t newBucketCount, size_t newStashBuckets)
+    {
+        bucketCount = newBucketCount;
+        stashBuckets = newStashBuckets;
+        buckets = static_cast<Bucket*>(::operator new((bucketCount + stashBuckets) * sizeof(Bucket),
+                                                      std::align_val_t(alignof(Bucket))));
+        for (size_t b = 0; b < bucketCount + stashBuckets; b++)
+        {
+            std::fill(buckets[b].tags, buckets[b].tags + SLOTS, TAG_EMPTY);
+        }
+    }
+
+    void release()
+    {
+        if (!buckets) return;
+        for (size_t b = 0; b < bucketCount + stashBuckets; b++)
+        {
+            for (size_t i = 0; i < SLOTS; i++)
+            {
+                if (buckets[b].tags[i] != TAG_EMPTY) node(b, i)->~HashNode();
+            }
+        }
+        ::operator delete(buckets, std::align_val_t(alignof(Bucket)));
+        buckets = nullptr;
+        bucketCount = 0;
+        tableSize = 0;
+        stashSize = 0;
+    }
+
+    /**
+     * Breadth-first search, from the two candidate buckets of hashValue, for a bucket with an empty slot,
+     * then move the nodes along the path so that the empty slot ends up in a candidate bucket
+     * A bucket is never visited twice on one path, so the moves never overwrite each other
+     * Time Complexity: O(MAX_SEARCH_BUCKETS * SLOTS * k)
+     * @return the slot index freed in a candidate bucket, or SIZE_MAX if no path was found
+     */
+    size_t makeRoom(size_t hashValue)
+    {
+        SearchStep queue[MAX_SEARCH_BUCKETS];
+        size_t queueSize = 2;
+        queue[0] = {firstBucket(hashValue), -1, 0};
+        queue[1] = {secondBucket(hashValue), -1, 0};
+        for (size_t q = 0; q < queueSize; q++)
+        {
+            size_t bucket = queue[q].bucket;
+            size_t empty = findEmptySlot(bucket);
+            if (empty != SLOTS)
+            {
+                size_t toBucket = bucket, toSlot = empty;
+                for (long step = (long)q; queue[(size_t)step].parent != -1; step = queue[(size_t)step].parent)
+                {
+                    size_t fromBucket = queue[(size_t)queue[(size_t)step].parent].bucket;
+                    size_t fromSlot = queue[(size_t)step].slot;
+                    moveNode(fromBucket, fromSlot, toBucket, toSlot);
+                    toBucket = fromBucket;
+                    toSlot = fromSlot;
+                }
+                return toBucket * SLOTS + toSlot;
+            }
+            for (size_t i = 0; i < SLOTS && queueSize < MAX_SEARCH_BUCKETS; i++)
+            {
+                size_t h = hashKey(node(bucket, i)->first);
+                size_t other = firstBucket(h) == bucket ? secondBucket(h) : firstBucket(h);
+                bool onPath = false;
+                for (long step = (long)q; step != -1 && !onPath; step = queue[(size_t)step].parent)
+                {
+                    onPath = queue[(size_t)step].bucket == other;
+                }
+                if (!onPath)
+                {
+                    queue[queueSize++] = {other, (long)q, i};
+                }
+            }
+        }
+        return SIZE_MAX;
+    }
+
+    /**
+     * Move every node to the same slot of a new array with newStashBuckets stash buckets
+     * Time Complexity: O(nk)
+     */
+    void growStash(size_t newStashBuckets)
+    {
+        Bucket* oldBuckets = buckets;
+        size_t oldStashBuckets = stashBuckets;
+        allocate(bucketCount, newStashBuckets);
+        for (size_t b = 0; b < bucketCount + oldStashBuckets; b++)
+        {
+            for (size_t i = 0; i < SLOTS; i++)
+            {
+                if (oldBuckets[b].tags[i] == TAG_EMPTY) continue;
+                HashNode* old = std::launder(reinterpret_cast<HashNode*>(&oldBuckets[b].slots[i]));
+                construct(b, i, oldBuckets[b].tags[i], std::move(old->first), std::move(old->second));
+                old->~HashNode();
+            }
+        }
+        ::operator delete(oldBuckets, std::align_val_t(alignof(Bucket)));
+    }
+
+    /**
+     * Insert a key known to be absent, no check of the load factor
+     * Try the two candidate buckets, then a path of moves, then the stash, and if all fail
+     * double the table and try again, or grow the stash if the table is too empty for doubling to help
+     * Time Complexity: O(k) expected, O(nk) with a resize
+     */
+    template <typename K, typename V>
+    void insertUnique(size_t hashValue, K&& key, V&& value)
+    {
+        uint8_t tag = tagOf(hashValue);
+        while (true)
+        {
+            size_t first = firstBucket(hashValue), second = secondBucket(hashValue);
+            size_t slot = findEmptySlot(first);
+            if (slot != SLOTS)
+            {
+                construct(first, slot, tag, std::forward<K>(key), std::forward<V>(value));
+                break;
+            }
+            slot = findEmptySlot(second);
+            if (slot != SLOTS)
+            {
+                construct(second, slot, tag, std::forward<K>(key), std::forward<V>(value));
+                break;
+            }
+            size_t index = makeRoom(hashValue);
+            if (index != SIZE_MAX)
+            {
+                construct(index / SLOTS, index % SLOTS, tag, std::forward<K>(key), std::forward<V>(value));
+                break;
+            }
+            index = findEmptyStashSlot();
+            if (index != SIZE_MAX)
+            {
+                construct(index / SLOTS, index % SLOTS, tag, std::forward<K>(key), std::forward<V>(value));
+                stashSize++;
+                break;
+            }
+            if (loadFactor() >= maxLoadFactor / 2)
+            {
+                achievableLoadFactor = loadFactor();
+                rehash(bucketCount * 2 * SLOTS, true);
+            }
+            else
+            {
+                // less than half as full as allowed, so doubling makes no progress: the keys crowding
+                // these buckets agree on the bits that choose buckets (or on the whole hash)
+                growStash(stashBuckets * 2);
+            }
+        }
+        tableSize++;
+    }
+
+    /**
+     * Move nodes of the stash into their buckets when these have room again
+     */
+    void drainStash()
+    {
+        for (size_t index = bucketCount * SLOTS; index < endIndex() && stashSize > 0; index++)
+        {
+            if (tagAt(index) == TAG_EMPTY) continue;
+            size_t h = hashKey(nodeAt(index)->first);
+            for (size_t bucket : {firstBucket(h), secondBucket(h)})
+            {
+                size_t slot = findEmptySlot(bucket);
+                if (slot != SLOTS)
+                {
+                    moveNode(index / SLOTS, index % SLOTS, bucket, slot);
+                    stashSize--;
+                    break;
+                }
+            }
+        }
+    }
+
+    /**
+     * Find the minimum number of buckets for the hashtable
+     * It is a power of 2, holds at least bucketSize slots,
+     * and keeps tableSize strictly below the maximum load
+     * Time Complexity: O(1)
+     */
+    size_t findMinimumBucketCount(size_t bucketSize) const
+    {
+        size_t result = MIN_BUCKET_COUNT;
+        while (result * SLOTS < bucketSize || (double)(tableSize + 1) > maxLoadFactor * (double)(result * SLOTS))
+        {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    void copyFrom(const CuckooHashTable& that)
+    {
+        allocate(that.bucketCount, that.stashBuckets);
+        for (size_t b = 0; b < bucketCount + stashBuckets; b++)
+        {
+            for (size_t i = 0; i < SLOTS; i++)
+            {
+                if (that.buckets[b].tags[i] != TAG_EMPTY)
+                {
+                    construct(b, i, that.buckets[b].tags[i], that.node(b, i)->first, that.node(b, i)->second);
+                }
+            }
+        }
+        tableSize = that.tableSize;
+        stashSize = that.stashSize;
+        achievableLoadFactor = that.achievableLoadFactor;
+    }
+
+    /**
+     * Grow if one more element would exceed the maximum load factor
+     */
+    void reserveOne()
+    {
+        if ((double)(tableSize + 1) > maxLoadFactor * (double)(bucketCount * SLOTS))
+        {
+            rehash(bucketCount * 2 * SLOTS);
+        }
+    }
+
+public:
+    CuckooHashTable() : maxLoadFactor(DEFAULT_LOAD_FACTOR), hash(Hash()), keyEqual(KeyEqual())
+    {
+        allocate(MIN_BUCKET_COUNT, 1);
+    }
+
+    explicit CuckooHashTable(size_t bucketSize) : maxLoadFactor(DEFAULT_LOAD_FACTOR), hash(Hash()), keyEqual(KeyEqual())
+    {
+        allocate(findMinimumBucketCount(bucketSize), 1);
+    }
+
+    CuckooHashTable(const CuckooHashTable& that) : maxLoadFactor(that.maxLoadFactor), hash(that.hash), keyEqual(that.keyEqual)
+    {
+        copyFrom(that);
+    }
+
+    CuckooHashTable& operator=(const CuckooHashTable& that)
+    {
+        if (this == &that) return *this;
+        release();
+        maxLoadFactor = that.maxLoadFactor;
+        hash = that.hash;
+        keyEqual = that.keyEqual;
+        copyFrom(that);
+        return *this;
+    }
+
+    ~CuckooHashTable()
+    {
+        release();
+    }
+
+    Iterator begin()
+    {
+        Iterator it(this, 0);
+        if (tagAt(0) == TAG_EMPTY) it.increment();
+        return it;
+    }
+
+    Iterator end()
+    {
+        return Iterator(this, endIndex());
+    }
+
+    /**
+     * Find whether the key exists in the hashtable
+     * Time Complexity: O(k)
+     * @param key
+     * @return whether the key exists in the hashtable
+     */
+    bool contains(const Key& key)
+    {
+        return find(key) != end();
+    }
+
+    /**
+     * Find the value in hashtable by key
+     * Reads the two candidate buckets, and the stash if it is not empty
+     * If the key exists, iterator points to the corresponding value, and it.endFlag = false
+     * Otherwise, iterator remembers the hash of the key, and it.endFlag = true
+     * Time Complexity: O(k), in the worst case
+     * @param key
+     * @return iterator of the value
+     */
+    Iterator find(const Key& key)
+    {
+        size_t hashValue = hashKey(key);
+        uint8_t tag = tagOf(hashValue);
+        size_t second = secondBucket(hashValue);
+        // load both buckets at once rather than one after the other on a miss in the first
+        __builtin_prefetch(&buckets[second]);
+        size_t index = findInBucket(firstBucket(hashValue), tag, key);
+        if (index == SIZE_MAX) index = findInBucket(second, tag, key);
+        if (index == SIZE_MAX && stashSize > 0) index = findInStash(tag, key);
+        if (index != SIZE_MAX)
+        {
+            return Iterator(this, index);
+        }
+        Iterator it = end();
+        it.hashValue = hashValue;
+        return it;
+    }
+
+    /**
+     * Insert value into the hashtable according to an iterator returned by find
+     * the function can be only be called if no other write actions are done to the hashtable after the find
+     * If the key already exists, overwrite its value
+     * If load factor exceeds maximum value, or no room can be made for the key, rehash the hashtable
+     * Time Complexity: Amortized O(k)
+     * @param it an iterator returned by find
+     * @param key
+     * @param value
+     * @return whether insertion took place (return false if the key already exists)
+     */
+    bool insert(const Iterator& it, const Key& key, const Value& value)
+    {
+        if (!it.endFlag)
+        {
+            nodeAt(it.index)->second = value;
+            return false;
+        }
+        reserveOne();
+        insertUnique(it.hashValue, key, value);
+        return true;
+    }
+
+    /**
+     * Insert <key, value> into the hashtable
+     * If the key already exists, overwrite its value
+     * Time Complexity: Amortized O(k)
+     * @param key
+     * @param value
+     * @return whether insertion took place (return false if the key already exists)
+     */
+    bool insert(const Key& key, const Value& value)
+    {
+        Iterator it = find(key);
+        return insert(it, key, value);
+    }
+
+    /**
+     * Erase the key if it exists in the hashtable, otherwise, do nothing
+     * Time Complexity: O(k)
+     * @param key
+     * @return whether the key exists
+     */
+    bool erase(const Key& key)
+    {
+        Iterator it = find(key);
+        bool keyExists = !it.endFlag;
+        if (keyExists)
+        {
+            erase(it);
+        }
+        return keyExists;
+    }
+
+    /**
+     * Erase the key at the input iterator
+     * If the input iterator is the end iterator, do nothing and return the input iterator directly
+     * A freed bucket slot may take back a node of the stash, the iterator returned accounts for it
+     * Time Complexity: O(1)
+     * @param it
+     * @return the iterator after the input iterator before the erase
+     */
+    Iterator erase(const Iterator& it)
+    {
+        if (it.endFlag)
+        {
+            return it;
+        }
+        size_t index = it.index;
+        destroy(index / SLOTS, index % SLOTS);
+        tableSize--;
+        if (index / SLOTS >= bucketCount)
+        {
+            stashSize--;
+        }
+        else if (stashSize > 0)
+        {
+            drainStash();
+            // a stash node moved into this slot is visited next
+            if (tagAt(index) != TAG_EMPTY) return Iterator(this, index);
+        }
+        Iterator nextIt(this, index);
+        nextIt.increment();
+        return nextIt;
+    }
+
+    /**
+     * Get the reference of value by key in the hashtable
+     * If the key doesn't exist, create it first (use default constructor of Value)
+     * Time Complexity: Amortized O(k)
+     * @param key
+     * @return reference of value
+     */
+    Value& operator[](const Key& key)
+    {
+        Iterator it = find(key);
+        if (!it.endFlag)
+        {
+            return nodeAt(it.index)->second;
+        }
+        reserveOne();
+        insertUnique(it.hashValue, key, Value());
+        return find(key)->second;
+    }
+
+    /**
+     * Rehash the hashtable according to the (hinted) number of slots
+     * The number of slots after rehash need not be same as the parameter bucketSize,
+     * it is the minimum power of 2 number of buckets keeping the load factor below its maximum
+     * Do nothing if the number of buckets doesn't change, unless forced
+     * Time Complexity: O(nk)
+     * @param bucketSize lower bound of the new number of slots
+     * @param force rebuild even if the number of buckets doesn't change
+     */
+    void rehash(size_t bucketSize, bool force = false)
+    {
+        size_t newBucketCount = findMinimumBucketCount(bucketSize);
+        if (newBucketCount == bucketCount && !force) return;
+        Bucket* oldBuckets = buckets;
+        size_t oldEnd = bucketCount + stashBuckets;
+        // a stash that overflowed keeps room for its nodes, most of which collide again
+        allocate(newBucketCount, std::max<size_t>(1, (stashSize + SLOTS - 1) / SLOTS));
+        tableSize = 0;
+        stashSize = 0;
+        for (size_t b = 0; b < oldEnd; b++)
+        {
+            for (size_t i = 0; i < SLOTS; i++)
+            {
+                if (oldBuckets[b].tags[i] == TAG_EMPTY) continue;
+                HashNode* old = std::launder(reinterpret_cast<HashNode*>(&oldBuckets[b].slots[i]));
+                // may double the new buckets again, the old ones stay until the end
+                insertUnique(hashKey(old->first), std::move(old->first), std::move(old->second));
+                old->~HashNode();
+            }
+        }
+        ::operator delete(oldBuckets, std::align_val_t(alignof(Bucket)));
+    }
+
+    /**
+     * @return the number of elements in the hashtable
+     */
+    size_t size() const { return tableSize; }
+
+    /**
+     * @return the number of slots in the hashtable, the stash aside
+     */
+    size_t bucketSize() const { return bucketCount * SLOTS; }
+
+    /**
+     * @return the current load factor of the hashtable
+     */
+    double loadFactor() const { return (double)tableSize / (double)(bucketCount * SLOTS); }
+
+    /**
+     * @return the maximum load factor of the hashtable
+     */
+    double getMaxLoadFactor() const { return maxLoadFactor; }
+
+    /**
+     * The load factor at which an insertion last found no room (both buckets full, no path of moves,
+     * stash full) and forced the table to double, 0 if that never happened
+     * Insertions that grew the stash instead are not counted
+     * Set the maximum load factor close to 1 to measure how full the table can get
+     */
+    double getAchievableLoadFactor() const { return achievableLoadFactor; }
+
+    /**
+     * @return the number of elements in the stash
+     */
+    size_t getStashSize() const { return stashSize; }
+
+    /**
+     * Set the max load factor
+     * @throw std::range_error if the load factor is too small, or above 1
+     * @param loadFactor
+     */
+    void setMaxLoadFactor(double loadFactor)
+    {
+        if (loadFactor <= 1e-9 || loadFactor > 1)
+        {
+            throw std::range_error("invalid load factor!");
+        }
+        maxLoadFactor = loadFactor;
+        rehash(bucketSize());
+    }
+
+    void printTable()
+    {
+        for (auto it = begin(); it != end(); ++it)
+        {
+            std::cout << it->first << ": " << it->second << "\n";
+        }
+    }
+};
+
+#endif //VE281P2_CUCKOO_HASHTABLE_HPP
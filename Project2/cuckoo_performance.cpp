@@ -0,0 +1,114 @@
+#include "cuckoo_hashtable.hpp"
+#include "flat_hashtable.hpp"
+#include "hashtable.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+using namespace std;
+
+// Usage: ./cuckoo_performance [max_log2_slots=22] [seed]
+// Output: two CSV tables, separated by an empty line
+//   slots,achievable_load_factor
+//     random int64 keys are inserted into a CuckooHashTable of 2^12 .. 2^max slots (maximum load factor 1)
+//     until an insertion finds no room; the load factor at that point is the achievable one
+//   table,n,insert,find_hit,find_miss,find_hit_max
+//     nanoseconds per operation on n = 0.9 * 2^max random int64 keys, found in random order,
+//     find_hit_max is the slowest of 64 batches of 1024 finds, per find
+
+double ns_since(chrono::steady_clock::time_point start, size_t ops)
+{
+    chrono::duration<double, nano> elapsed = chrono::steady_clock::now() - start;
+    return elapsed.count() / (double)ops;
+}
+
+void achievable_load_factor(size_t slots, mt19937_64 &gen)
+{
+    CuckooHashTable<long, long> table(slots);
+    table.setMaxLoadFactor(1.0);
+    size_t before = table.bucketSize();
+    while (table.bucketSize() == before)
+    {
+        table.insert((long)gen(), 0);
+    }
+    printf("%zu,%.4f\n", before, table.getAchievableLoadFactor());
+    fflush(stdout);
+}
+
+template <typename Table>
+void lookups(const char *name, const vector<long> &keys, const vector<long> &hit_order, const vector<long> &misses)
+{
+    size_t n = keys.size();
+    Table table;
+    auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i < n; i++)
+    {
+        table.insert(keys[i], (long)i);
+    }
+    double insert_time = ns_since(start, n);
+
+    size_t found = 0;
+    start = chrono::steady_clock::now();
+    for (long k : hit_order)
+    {
+        found += table.find(k) != table.end();
+    }
+    double hit_time = ns_since(start, n);
+
+    start = chrono::steady_clock::now();
+    for (long k : misses)
+    {
+        found += table.find(k) != table.end();
+    }
+    double miss_time = ns_since(start, n);
+
+    double hit_max = 0;
+    for (size_t batch = 0; batch < 64; batch++)
+    {
+        size_t first = (batch * 1024 * 7919) % (n - min<size_t>(n, 1024) + 1);
+        size_t last = min(n, first + 1024);
+        start = chrono::steady_clock::now();
+        for (size_t i = first; i < last; i++)
+        {
+            found += table.find(hit_order[i]) != table.end();
+        }
+        hit_max = max(hit_max, ns_since(start, last - first));
+    }
+    if (found != n + 64 * min<size_t>(n, 1024))
+    {
+        fprintf(stderr, "%s: wrong number of keys found\n", name);
+        exit(1);
+    }
+    printf("%s,%zu,%.2f,%.2f,%.2f,%.2f\n", name, n, insert_time, hit_time, miss_time, hit_max);
+    fflush(stdout);
+}
+
+int main(int argc, char *argv[])
+{
+    int max_log2 = argc > 1 ? atoi(argv[1]) : 22;
+    unsigned long seed = argc > 2 ? strtoul(argv[2], nullptr, 10) : 281;
+    mt19937_64 gen(seed);
+
+    printf("slots,achievable_load_factor\n");
+    for (int e = 12; e <= max_log2; e++)
+    {
+        achievable_load_factor((size_t)1 << e, gen);
+    }
+
+    size_t n = (size_t)(0.9 * (double)((size_t)1 << max_log2));
+    vector<long> keys(n), misses(n);
+    for (size_t i = 0; i < n; i++)
+    {
+        keys[i] = (long)gen();
+        misses[i] = (long)gen();
+    }
+    vector<long> hit_order = keys;
+    shuffle(hit_order.begin(), hit_order.end(), gen);
+    printf("\ntable,n,insert,find_hit,find_miss,find_hit_max\n");
+    lookups<CuckooHashTable<long, long>>("CuckooHashTable", keys, hit_order, misses);
+    lookups<FlatHashTable<long, long>>("FlatHashTable", keys, hit_order, misses);
+    lookups<HashTable<long, long>>("HashTable", keys, hit_order, misses);
+    return 0;
+}
@@ -0,0 +1,571 @@
+#ifndef VE281P2_FLAT_HASHTABLE_HPP
+#define VE281P2_FLAT_HASHTABLE_HPP
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <utility>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/**
+ * An open addressing hashtable in the style of SwissTable
+ * Slots are stored inline in one array, next to an array of one control byte per slot:
+ * - empty (0x80) and deleted (0xFE) have the high bit set
+ * - a full slot stores the low 7 bits of the hash (H2)
+ * The slots are probed a group of 16 at a time: one SSE2 compare finds every slot of
+ * the group whose H2 matches, so KeyEqual is almost only called on real hits.
+ * Groups are probed triangularly starting at group H1 (the remaining hash bits).
+ * Same public API as HashTable
+ * @tparam Key          key type
+ * @tparam Value        data type
+ * @tparam Hash         function object, return the hash value of a key
+ * @tparam KeyEqual     function object, return whether two keys are the same
+ */
+template <
+    typename Key, typename Value,
+    typename Hash = std::hash<Key>,
+    typename KeyEqual = std::equal_to<Key>
+>
+class FlatHashTable
+{
+public:
+    /**
+     * What an iterator refers to: the key can only be read, the value can also be written
+     * Slots hold a mutable pair<Key, Value> so that a rehash can move the keys
+     */
+    struct Reference
+    {
+        const Key& first;
+        Value& second;
+
+        Reference* operator->() { return this; }
+    };
+
+    /**
+     * A single directional iterator for the hashtable
+     */
+    class Iterator
+    {
+    private:
+        FlatHashTable* hashTable;
+        size_t index;          // slot index, capacity for the end iterator
+        size_t hashValue = 0;  // hash of the key a failed find was looking for
+        bool endFlag = false;  // whether it is an end iterator
+
+        /**
+         * Increment the iterator
+         * Time complexity: Amortized O(1)
+         */
+        void increment()
+        {
+            while (++index < hashTable->capacity)
+            {
+                if (hashTable->ctrl[index] >= 0) return;
+            }
+            endFlag = true;
+        }
+
+        Iterator(FlatHashTable* hashTable, size_t index) : hashTable(hashTable), index(index)
+        {
+            endFlag = index >= hashTable->capacity;
+        }
+
+    public:
+        friend class FlatHashTable;
+
+        Iterator() = delete;
+
+        Iterator(const Iterator&) = default;
+
+        Iterator& operator=(const Iterator&) = default;
+
+        Iterator& operator++()
+        {
+            increment();
+            return *this;
+        }
+
+        Iterator operator++(int)
+        {
+            Iterator temp = *this;
+            increment();
+            return temp;
+        }
+
+        bool operator==(const Iterator& that) const
+        {
+            if (endFlag && that.endFlag)
+                return true;
+            return !endFlag && !that.endFlag && index == that.index;
+        }
+
+        bool operator!=(const Iterator& that) const
+        {
+            return !(*this == that);
+        }
+
+        Reference operator->()
+        {
+            return **this;
+        }
+
+        Reference operator*()
+        {
+            HashNode& node = hashTable->slots[index];
+            return {node.first, node.second};
+        }
+    };
+
+protected:
+    typedef std::pair<Key, Value> HashNode;
+
+    static constexpr double DEFAULT_LOAD_FACTOR = 0.875; // default maximum load factor is 7/8
+    static constexpr size_t GROUP_SIZE = 16;
+    static constexpr int8_t CTRL_EMPTY = -128;
+    static constexpr int8_t CTRL_DELETED = -2;
+
+    /**
+     * 16 control bytes, each match returns a bit mask of the matching slots
+     */
+    struct Group
+    {
+#ifdef __SSE2__
+        __m128i ctrl;
+
+        explicit Group(const int8_t* pos) : ctrl(_mm_load_si128(reinterpret_cast<const __m128i*>(pos))) {}
+
+        uint32_t match(int8_t h2) const
+        {
+            return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), ctrl));
+        }
+
+        uint32_t matchEmpty() const
+        {
+            return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(CTRL_EMPTY), ctrl));
+        }
+
+        uint32_t matchEmptyOrDeleted() const
+        {
+            return (uint32_t)_mm_movemask_epi8(ctrl);
+        }
+#else
+        const int8_t* ctrl;
+
+        explicit Group(const int8_t* pos) : ctrl(pos) {}
+
+        uint32_t match(int8_t h2) const
+        {
+            uint32_t mask = 0;
+            for (size_t i = 0; i < GROUP_SIZE; i++) mask |= (uint32_t)(ctrl[i] == h2) << i;
+            return mask;
+        }
+
+        uint32_t matchEmpty() const { return match(CTRL_EMPTY); }
+
+        uint32_t matchEmptyOrDeleted() const
+        {
+            uint32_t mask = 0;
+            for (size_t i = 0; i < GROUP_SIZE; i++) mask |= (uint32_t)(ctrl[i] < 0) << i;
+            return mask;
+        }
+#endif
+    };
+
+    int8_t* ctrl = nullptr;   // control bytes, aligned to GROUP_SIZE
+    HashNode* slots = nullptr;
+    size_t capacity = 0;      // number of slots, a power of 2 and a multiple of GROUP_SIZE
+    size_t tableSize = 0;     // number of elements
+    size_t deletedSize = 0;   // number of tombstones
+    double maxLoadFactor;     // maximum load factor
+    Hash hash;                // hash function instance
+    KeyEqual keyEqual;        // key equal function instance
+
+    /**
+     * Mix the user hash so that H1 and H2 both depend on every bit
+     * (std::hash of integers is the identity)
+     */
+    inline size_t hashKey(const Key& key) const
+    {
+        uint64_t h = (uint64_t)hash(key);
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        return (size_t)h;
+    }
+
+    static int8_t H2(size_t hashValue) { return (int8_t)(hashValue & 0x7F); }
+
+    static size_t H1(size_t hashValue) { return hashValue >> 7; }
+
+    static uint32_t lowestBit(uint32_t mask) { return (uint32_t)__builtin_ctz(mask); }
+
+    /**
+     * Find the minimum capacity for the hashtable
+     * It is a power of 2, at least GROUP_SIZE and bucketSize,
+     * and keeps tableSize strictly below the maximum load
+     * Time Complexity: O(1)
+     */
+    size_t findMinimumCapacity(size_t bucketSize) const
+    {
+        size_t result = GROUP_SIZE;
+        while (result < bucketSize || (double)(tableSize + 1) > maxLoadFactor * (double)result)
+        {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    void allocate(size_t newCapacity)
+    {
+        capacity = newCapacity;
+        ctrl = static_cast<int8_t*>(::operator new(capacity, std::align_val_t(GROUP_SIZE)));
+        std::fill(ctrl, ctrl + capacity, CTRL_EMPTY);
+        slots = std::allocator<HashNode>().allocate(capacity);
+    }
+
+    void release()
+    {
+        if (!ctrl) return;
+        for (size_t i = 0; i < capacity; i++)
+        {
+            if (ctrl[i] >= 0) slots[i].~HashNode();
+        }
+        ::operator delete(ctrl, std::align_val_t(GROUP_SIZE));
+        std::allocator<HashNode>().deallocate(slots, capacity);
+        ctrl = nullptr;
+        slots = nullptr;
+        capacity = 0;
+        tableSize = 0;
+        deletedSize = 0;
+    }
+
+    /**
+     * Time Complexity: Amortized O(k)
+     * @return the slot of the first empty or deleted slot in the probe sequence of hashValue
+     */
+    size_t findInsertSlot(size_t hashValue) const
+    {
+        size_t groupMask = capacity / GROUP_SIZE - 1;
+        size_t group = H1(hashValue) & groupMask;
+        for (size_t step = 1;; step++)
+        {
+            uint32_t mask = Group(ctrl + group * GROUP_SIZE).matchEmptyOrDeleted();
+            if (mask) return group * GROUP_SIZE + lowestBit(mask);
+            group = (group + step) & groupMask;
+        }
+    }
+
+    /**
+     * Insert a key known to be absent without any check, no rehash
+     */
+    template <typename K, typename V>
+    size_t insertUnique(size_t hashValue, K&& key, V&& value)
+    {
+        size_t index = findInsertSlot(hashValue);
+        if (ctrl[index] == CTRL_DELETED) deletedSize--;
+        ctrl[index] = H2(hashValue);
+        new (&slots[index]) HashNode(std::forward<K>(key), std::forward<V>(value));
+        tableSize++;
+        return index;
+    }
+
+    void copyFrom(const FlatHashTable& that)
+    {
+        allocate(that.capacity);
+        for (size_t i = 0; i < that.capacity; i++)
+        {
+            if (that.ctrl[i] >= 0)
+            {
+                ctrl[i] = that.ctrl[i];
+                new (&slots[i]) HashNode(that.slots[i]);
+            }
+            else
+            {
+                ctrl[i] = that.ctrl[i];
+            }
+        }
+        tableSize = that.tableSize;
+        deletedSize = that.deletedSize;
+    }
+
+public:
+    FlatHashTable() : maxLoadFactor(DEFAULT_LOAD_FACTOR), hash(Hash()), keyEqual(KeyEqual())
+    {
+        allocate(GROUP_SIZE);
+    }
+
+    explicit FlatHashTable(size_t bucketSize) : maxLoadFactor(DEFAULT_LOAD_FACTOR), hash(Hash()), keyEqual(KeyEqual())
+    {
+        allocate(findMinimumCapacity(bucketSize));
+    }
+
+    FlatHashTable(const FlatHashTable& that) : maxLoadFactor(that.maxLoadFactor), hash(that.hash), keyEqual(that.keyEqual)
+    {
+        copyFrom(that);
+    }
+
+    FlatHashTable& operator=(const FlatHashTable& that)
+    {
+        if (this == &that) return *this;
+        release();
+        maxLoadFactor = that.maxLoadFactor;
+        hash = that.hash;
+        keyEqual = that.keyEqual;
+        copyFrom(that);
+        return *this;
+    }
+
+    ~FlatHashTable()
+    {
+        release();
+    }
+
+    Iterator begin()
+    {
+        Iterator it(this, 0);
+        if (capacity && ctrl[0] < 0) it.increment();
+        return it;
+    }
+
+    Iterator end()
+    {
+        return Iterator(this, capacity);
+    }
+
+    /**
+     * Find whether the key exists in the hashtable
+     * Time Complexity: Amortized O(k)
+     * @param key
+     * @return whether the key exists in the hashtable
+     */
+    bool contains(const Key& key)
+    {
+        return find(key) != end();
+    }
+
+    /**
+     * Find the value in hashtable by key
+     * If the key exists, iterator points to the corresponding value, and it.endFlag = false
+     * Otherwise, iterator remembers the hash of the key, and it.endFlag = true
+     * Time Complexity: Amortized O(k)
+     * @param key
+     * @return iterator of the value
+     */
+    Iterator find(const Key& key)
+    {
+        size_t hashValue = hashKey(key);
+        int8_t h2 = H2(hashValue);
+        size_t groupMask = capacity / GROUP_SIZE - 1;
+        size_t group = H1(hashValue) & groupMask;
+        for (size_t step = 1; step <= groupMask + 1; step++)
+        {
+            Group g(ctrl + group * GROUP_SIZE);
+            for (uint32_t mask = g.match(h2); mask; mask &= mask - 1)
+            {
+                size_t index = group * GROUP_SIZE + lowestBit(mask);
+                if (keyEqual(slots[index].first, key))
+                {
+                    return Iterator(this, index);
+                }
+            }
+            if (g.matchEmpty()) break;
+            group = (group + step) & groupMask;
+        }
+        Iterator it = end();
+        it.hashValue = hashValue;
+        return it;
+    }
+
+    /**
+     * Insert value into the hashtable according to an iterator returned by find
+     * the function can be only be called if no other write actions are done to the hashtable after the find
+     * If the key already exists, overwrite its value
+     * If load factor exceeds maximum value, rehash the hashtable
+     * Time Complexity: Amortized O(k)
+     * @param it an iterator returned by find
+     * @param key
+     * @param value
+     * @return whether insertion took place (return false if the key already exists)
+     */
+    bool insert(const Iterator& it, const Key& key, const Value& value)
+    {
+        if (!it.endFlag)
+        {
+            slots[it.index].second = value;
+            return false;
+        }
+        if ((double)(tableSize + deletedSize + 1) > maxLoadFactor * (double)capacity)
+        {
+            // mostly tombstones: clean up in place, otherwise grow
+            rehash((double)(tableSize + 1) > maxLoadFactor * (double)capacity / 2 ? capacity * 2 : capacity, true);
+        }
+        insertUnique(it.hashValue, key, value);
+        return true;
+    }
+
+    /**
+     * Insert <key, value> into the hashtable
+     * If the key already exists, overwrite its value
+     * If load factor exceeds maximum value, rehash the hashtable
+     * Time Complexity: Amortized O(k)
+     * @param key
+     * @param value
+     * @return whether insertion took place (return false if the key already exists)
+     */
+    bool insert(const Key& key, const Value& value)
+    {
+        Iterator it = find(key);
+        return insert(it, key, value);
+    }
+
+    /**
+     * Erase the key if it exists in the hashtable, otherwise, do nothing
+     * Time Complexity: Amortized O(k)
+     * @param key
+     * @return whether the key exists
+     */
+    bool erase(const Key& key)
+    {
+        Iterator it = find(key);
+        bool keyExists = !it.endFlag;
+        if (keyExists)
+        {
+            erase(it);
+        }
+        return keyExists;
+    }
+
+    /**
+     * Erase the key at the input iterator
+     * If the input iterator is the end iterator, do nothing and return the input iterator directly
+     * The slot becomes empty if its group still has an empty slot (then no probe sequence
+     * ever continued past this group), otherwise it becomes a tombstone
+     * Time Complexity: O(1)
+     * @param it
+     * @return the iterator after the input iterator before the erase
+     */
+    Iterator erase(const Iterator& it)
+    {
+        if (it.endFlag)
+        {
+            return it;
+        }
+        Iterator nextIt = it;
+        ++nextIt;
+        size_t index = it.index;
+        slots[index].~HashNode();
+        if (Group(ctrl + index / GROUP_SIZE * GROUP_SIZE).matchEmpty())
+        {
+            ctrl[index] = CTRL_EMPTY;
+        }
+        else
+        {
+            ctrl[index] = CTRL_DELETED;
+            deletedSize++;
+        }
+        tableSize--;
+        return nextIt;
+    }
+
+    /**
+     * Get the reference of value by key in the hashtable
+     * If the key doesn't exist, create it first (use default constructor of Value)
+     * If load factor exceeds maximum value, rehash the hashtable
+     * Time Complexity: Amortized O(k)
+     * @param key
+     * @return reference of value
+     */
+    Value& operator[](const Key& key)
+    {
+        Iterator it = find(key);
+        if (!it.endFlag)
+        {
+            return slots[it.index].second;
+        }
+        if ((double)(tableSize + deletedSize + 1) > maxLoadFactor * (double)capacity)
+        {
+            rehash((double)(tableSize + 1) > maxLoadFactor * (double)capacity / 2 ? capacity * 2 : capacity, true);
+        }
+        return slots[insertUnique(it.hashValue, key, Value())].second;
+    }
+
+    /**
+     * Rehash the hashtable according to the (hinted) number of slots
+     * The capacity after rehash need not be same as the parameter bucketSize,
+     * it is the minimum power of 2 keeping the load factor below its maximum
+     * Do nothing if the capacity doesn't change and there are no tombstones, unless forced
+     * Time Complexity: O(nk)
+     * @param bucketSize lower bound of the new number of slots
+     * @param force rebuild even if the capacity doesn't change
+     */
+    void rehash(size_t bucketSize, bool force = false)
+    {
+        size_t newCapacity = findMinimumCapacity(bucketSize);
+        if (newCapacity == capacity && deletedSize == 0 && !force) return;
+        int8_t* oldCtrl = ctrl;
+        HashNode* oldSlots = slots;
+        size_t oldCapacity = capacity;
+        allocate(newCapacity);
+        tableSize = 0;
+        deletedSize = 0;
+        for (size_t i = 0; i < oldCapacity; i++)
+        {
+            if (oldCtrl[i] < 0) continue;
+            HashNode& node = oldSlots[i];
+            insertUnique(hashKey(node.first), std::move(node.first), std::move(node.second));
+            node.~HashNode();
+        }
+        ::operator delete(oldCtrl, std::align_val_t(GROUP_SIZE));
+        std::allocator<HashNode>().deallocate(oldSlots, oldCapacity);
+    }
+
+    /**
+     * @return the number of elements in the hashtable
+     */
+    size_t size() const { return tableSize; }
+
+    /**
+     * @return the number of slots in the hashtable
+     */
+    size_t bucketSize() const { return capacity; }
+
+    /**
+     * @return the current load factor of the hashtable
+     */
+    double loadFactor() const { return (double)tableSize / (double)capacity; }
+
+    /**
+     * @return the maximum load factor of the hashtable
+     */
+    double getMaxLoadFactor() const { return maxLoadFactor; }
+
+    /**
+     * Set the max load factor
+     * @throw std::range_error if the load factor is too small, or not below 1
+     * @param loadFactor
+     */
+    void setMaxLoadFactor(double loadFactor)
+    {
+        if (loadFactor <= 1e-9 || loadFactor >= 1)
+        {
+            throw std::range_error("invalid load factor!");
+        }
+        maxLoadFactor = loadFactor;
+        rehash(capacity);
+    }
+
+    void printTable()
+    {
+        for (auto it = begin(); it != end(); ++it)
+        {
+            std::cout << it->first << ": " << it->second << "\n";
+        }
+    }
+};
+
+#endif //VE281P2_FLAT_HASHTABLE_HPP
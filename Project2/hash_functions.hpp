@@ -0,0 +1,304 @@
+#ifndef VE281P2_HASH_FUNCTIONS_HPP
+#define VE281P2_HASH_FUNCTIONS_HPP
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <string_view>
+#include <type_traits>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+/**
+ * Transparent hash of strings, std::string, std::string_view and const char*
+ * with the same characters get the same hash (that of std::hash<std::string>)
+ * Use it with std::equal_to<> as KeyEqual for heterogeneous lookup in HashTable
+ */
+struct StringHash
+{
+    typedef void is_transparent;
+
+    size_t operator()(std::string_view s) const
+    {
+        return std::hash<std::string_view>()(s);
+    }
+};
+
+namespace HashFunctions
+{
+    __extension__ typedef unsigned __int128 uint128_t;
+
+    // the secret of wyhash
+    static constexpr uint64_t SECRET[4] = {
+        0xa0761d6478bd642fULL, 0xe7037ed1a0b428dbULL, 0x8ebc6af09c88c6e3ULL, 0x589965cc75374cc3ULL
+    };
+    static constexpr size_t STRIPE_THRESHOLD = 256;  // inputs at least this long are hashed by stripes
+    static constexpr size_t STRIPE_SIZE = 32;        // bytes, one 64-bit lane per accumulator
+    static constexpr size_t STRIPES_PER_SCRAMBLE = 16;
+    // stripe s of a scramble block is keyed with words s .. s + 3, the scramble with the last 4 words
+    static constexpr size_t STRIPE_KEY_WORDS = STRIPES_PER_SCRAMBLE + 4;
+    // mix64(SECRET[j % 4] * (j + 1)), the seed is added to the even words and subtracted from the odd ones
+    static constexpr uint64_t STRIPE_SECRET[STRIPE_KEY_WORDS] = {
+        0x7de53de772ea694cULL, 0x568b60241dec7699ULL, 0xe4228148d71b1f28ULL, 0xf4c51b225e12c025ULL,
+        0x8910fb6669727139ULL, 0x5b58d56a5a4a7c5bULL, 0xba72608a693969dbULL, 0xe98a3646bc25804aULL,
+        0xc24af1a4c18637f1ULL, 0x60141200a32b3cacULL, 0x1f2385b1191aab3cULL, 0x45289deef2fd2addULL,
+        0x94f7641a99c87102ULL, 0x8a8bc97f3d844c11ULL, 0x9c7e4cefb9c4f10dULL, 0xb0015e46c358c5dbULL,
+        0x40100b3c3f7ac2f2ULL, 0xf8502c3326ecea32ULL, 0xb5680d64ad47f956ULL, 0x22103b1e6dd702cdULL
+    };
+    static constexpr uint64_t SCRAMBLE_PRIME = 0x9E3779B1ULL;
+
+    /**
+     * splitmix64 finalizer: a bijection of 64-bit integers in which every input bit affects every output bit
+     */
+    inline uint64_t mix64(uint64_t x)
+    {
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+        return x ^ (x >> 31);
+    }
+
+    /**
+     * Fold the 128-bit product of a and b
+     */
+    inline uint64_t mum(uint64_t a, uint64_t b)
+    {
+        uint128_t r = (uint128_t)a * b;
+        return (uint64_t)r ^ (uint64_t)(r >> 64);
+    }
+
+    inline uint64_t read8(const unsigned char* p)
+    {
+        uint64_t v;
+        std::memcpy(&v, p, 8);
+        return v;
+    }
+
+    inline uint64_t read4(const unsigned char* p)
+    {
+        uint32_t v;
+        std::memcpy(&v, p, 4);
+        return v;
+    }
+
+    /**
+     * Word j of the key of the stripes, for this seed
+     */
+    inline uint64_t stripeKey(size_t j, uint64_t seed)
+    {
+        return STRIPE_SECRET[j] + (j % 2 == 0 ? seed : 0 - seed);
+    }
+
+    /**
+     * Accumulate whole stripes of 32 bytes into 4 lanes, in the style of xxh3:
+     * lane i adds its 8 bytes d and the 32 x 32-bit product of the halves of d ^ stripeKey(s + i, seed)
+     * for stripe s of a block of STRIPES_PER_SCRAMBLE stripes, after which the lanes are scrambled
+     * Each stripe of a block has its own key, so swapping two stripes changes the hash
+     * The AVX2 and the scalar versions give the same result
+     */
+    inline void accumulateStripes(uint64_t acc[4], const unsigned char* p, size_t stripes, uint64_t seed)
+    {
+#ifdef __AVX2__
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(acc));
+        // the seed added to 4 key words from an even and from an odd word on
+        const __m256i evenSeed = _mm256_set_epi64x((long long)(0 - seed), (long long)seed,
+                                                   (long long)(0 - seed), (long long)seed);
+        const __m256i oddSeed = _mm256_sub_epi64(_mm256_setzero_si256(), evenSeed);
+        const __m256i scrambleKey = _mm256_add_epi64(
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(STRIPE_SECRET + STRIPES_PER_SCRAMBLE)), evenSeed);
+        const __m256i prime = _mm256_set1_epi64x((long long)SCRAMBLE_PRIME);
+        auto accumulate = [&](const unsigned char* stripe, size_t word)
+        {
+            __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(stripe));
+            __m256i key = _mm256_add_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(STRIPE_SECRET + word)),
+                                           word % 2 == 0 ? evenSeed : oddSeed);
+            __m256i dk = _mm256_xor_si256(d, key);
+            a = _mm256_add_epi64(a, d);
+            a = _mm256_add_epi64(a, _mm256_mul_epu32(dk, _mm256_srli_epi64(dk, 32)));
+        };
+        size_t s = 0;
+        for (; s + STRIPES_PER_SCRAMBLE <= stripes; s += STRIPES_PER_SCRAMBLE)
+        {
+            for (size_t w = 0; w < STRIPES_PER_SCRAMBLE; w++)
+            {
+                accumulate(p + (s + w) * STRIPE_SIZE, w);
+            }
+            a = _mm256_xor_si256(_mm256_xor_si256(a, _mm256_srli_epi64(a, 47)), scrambleKey);
+            // a * prime modulo 2^64, from two 32 x 32-bit products
+            __m256i low = _mm256_mul_epu32(a, prime);
+            __m256i high = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), prime);
+            a = _mm256_add_epi64(low, _mm256_slli_epi64(high, 32));
+        }
+        for (size_t w = 0; s + w < stripes; w++)
+        {
+            accumulate(p + (s + w) * STRIPE_SIZE, w);
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(acc), a);
+#else
+        uint64_t key[STRIPE_KEY_WORDS];
+        for (size_t j = 0; j < STRIPE_KEY_WORDS; j++)
+        {
+            key[j] = stripeKey(j, seed);
+        }
+        auto accumulate = [&](const unsigned char* stripe, size_t word)
+        {
+            for (size_t i = 0; i < 4; i++)
+            {
+                uint64_t d = read8(stripe + i * 8);
+                uint64_t dk = d ^ key[word + i];
+                acc[i] += d + (dk & 0xFFFFFFFFULL) * (dk >> 32);
+            }
+        };
+        size_t s = 0;
+        for (; s + STRIPES_PER_SCRAMBLE <= stripes; s += STRIPES_PER_SCRAMBLE)
+        {
+            for (size_t w = 0; w < STRIPES_PER_SCRAMBLE; w++)
+            {
+                accumulate(p + (s + w) * STRIPE_SIZE, w);
+            }
+            for (size_t i = 0; i < 4; i++)
+            {
+                acc[i] = (acc[i] ^ (acc[i] >> 47) ^ key[STRIPES_PER_SCRAMBLE + i]) * SCRAMBLE_PRIME;
+            }
+        }
+        for (size_t w = 0; s + w < stripes; w++)
+        {
+            accumulate(p + (s + w) * STRIPE_SIZE, w);
+        }
+#endif
+    }
+
+    /**
+     * A wyhash style hash of len bytes at data
+     * Inputs shorter than STRIPE_THRESHOLD are mixed 16 bytes at a time with 64 x 64 -> 128-bit multiplies,
+     * longer ones are first accumulated by stripes (with AVX2 when compiled with -mavx2), keyed by the seed
+     * Time Complexity: O(len)
+     */
+    inline uint64_t hashBytes(const void* data, size_t len, uint64_t seed)
+    {
+        const unsigned char* p = static_cast<const unsigned char*>(data);
+        seed ^= mum(seed ^ SECRET[0], SECRET[1]);
+        size_t left = len;
+        if (len >= STRIPE_THRESHOLD)
+        {
+            uint64_t acc[4];
+            for (size_t i = 0; i < 4; i++)
+            {
+                acc[i] = seed ^ SECRET[i];
+            }
+            size_t stripes = len / STRIPE_SIZE;
+            accumulateStripes(acc, p, stripes, seed);
+            seed = mum(acc[0] ^ SECRET[0], acc[1] ^ seed) ^ mum(acc[2] ^ SECRET[2], acc[3] ^ SECRET[3]);
+            p += stripes * STRIPE_SIZE;
+            left -= stripes * STRIPE_SIZE;
+        }
+        uint64_t a, b;
+        if (left <= 16)
+        {
+            if (left >= 4)
+            {
+                a = (read4(p) << 32) | read4(p + ((left >> 3) << 2));
+                b = (read4(p + left - 4) << 32) | read4(p + left - 4 - ((left >> 3) << 2));
+            }
+            else if (left > 0)
+            {
+                a = ((uint64_t)p[0] << 16) | ((uint64_t)p[left >> 1] << 8) | p[left - 1];
+                b = 0;
+            }
+            else
+            {
+                a = b = 0;
+            }
+        }
+        else
+        {
+            while (left > 16)
+            {
+                seed = mum(read8(p) ^ SECRET[1], read8(p + 8) ^ seed);
+                p += 16;
+                left -= 16;
+            }
+            // the last 16 bytes, overlapping the ones already mixed
+            a = read8(p + left - 16);
+            b = read8(p + left - 8);
+        }
+        a ^= SECRET[1];
+        b ^= seed;
+        uint128_t r = (uint128_t)a * b;
+        a = (uint64_t)r;
+        b = (uint64_t)(r >> 64);
+        return mum(a ^ SECRET[0] ^ len, b ^ SECRET[1]);
+    }
+
+    /**
+     * A seed that differs between processes and between calls
+     */
+    inline uint64_t randomSeed()
+    {
+        static const uint64_t processSeed = ((uint64_t)std::random_device()() << 32) ^ std::random_device()() ^
+            (uint64_t)std::chrono::steady_clock::now().time_since_epoch().count();
+        static std::atomic<uint64_t> counter{0};
+        return mix64(processSeed + SECRET[2] * ++counter);
+    }
+}
+
+/**
+ * Hash of integers that mixes every bit into the low ones (splitmix64 finalizer)
+ * std::hash of an integer is the identity, so sequential or strided keys fill buckets unevenly
+ * whenever the bucket count shares factors with the stride; this mixer removes that
+ */
+struct IntegerHash
+{
+    template <typename T, typename = typename std::enable_if<std::is_integral<T>::value>::type>
+    size_t operator()(T x) const
+    {
+        return (size_t)HashFunctions::mix64((uint64_t)x);
+    }
+};
+
+/**
+ * Transparent wyhash style hash of strings, much faster than std::hash on long strings
+ * Not seeded: the hash of a string is the same in every process, see SeededHash
+ */
+struct FastStringHash
+{
+    typedef void is_transparent;
+
+    size_t operator()(std::string_view s) const
+    {
+        return (size_t)HashFunctions::hashBytes(s.data(), s.size(), 0);
+    }
+};
+
+/**
+ * Hash of strings and integers with a secret seed, chosen at random for every instance unless given,
+ * so that inputs crafted to collide in one process (hash flooding) do not collide in another
+ * Tables built with the same seed hash the same, e.g. to compare hashes across tables
+ */
+struct SeededHash
+{
+    typedef void is_transparent;
+
+    uint64_t seed;
+
+    SeededHash() : seed(HashFunctions::randomSeed()) {}
+
+    explicit SeededHash(uint64_t seed) : seed(seed) {}
+
+    size_t operator()(std::string_view s) const
+    {
+        return (size_t)HashFunctions::hashBytes(s.data(), s.size(), seed);
+    }
+
+    template <typename T, typename = typename std::enable_if<std::is_integral<T>::value>::type>
+    size_t operator()(T x) const
+    {
+        return (size_t)HashFunctions::mum((uint64_t)x ^ seed, HashFunctions::SECRET[1] ^ seed);
+    }
+};
+
+#endif //VE281P2_HASH_FUNCTIONS_HPP
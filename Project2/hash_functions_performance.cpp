@@ -0,0 +1,170 @@
+#include "hash_functions.hpp"
+#include "hashtable.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+using namespace std;
+
+// Usage: ./hash_functions_performance [n=1000000] [seed]
+// Build with -mavx2 to use the AVX2 path of FastStringHash and SeededHash on long strings
+// Output: two CSV tables, separated by an empty line
+//   hash,keys,length,ns_per_hash,gb_per_s
+//     throughput on integers and on strings of 8 to 4096 bytes
+//   hash,keys,policy,n,max_chain,hot_fraction,average_probes
+//     chains of HashTable after inserting n keys, average_probes is over finds of every key
+//     policy mask uses the low bits of the hash directly, as FlatHashTable and most power-of-two tables do
+
+/**
+ * Power-of-two bucket counts indexed by the low bits of the hash, without any mixing
+ */
+class MaskBucketPolicy
+{
+private:
+    size_t mask = 0;
+
+public:
+    static size_t roundUp(size_t n) { return PowerOfTwoBucketPolicy::roundUp(n); }
+    void reset(size_t bucketSize) { mask = bucketSize - 1; }
+    size_t bucket(size_t hashValue) const { return hashValue & mask; }
+};
+
+struct std_hash
+{
+    size_t operator()(long x) const { return hash<long>()(x); }
+    size_t operator()(string_view s) const { return hash<string_view>()(s); }
+};
+
+// written after every timed loop, so that the hashes are not optimized away
+volatile size_t sink_total = 0;
+
+double seconds_since(chrono::steady_clock::time_point start)
+{
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+template <typename Hash>
+void throughput_integers(const char *name, const vector<long> &keys)
+{
+    Hash h;
+    size_t sink = 0;
+    auto start = chrono::steady_clock::now();
+    for (int rep = 0; rep < 10; rep++)
+    {
+        for (long k : keys)
+        {
+            sink += h(k);
+        }
+    }
+    double seconds = seconds_since(start);
+    double hashes = 10.0 * (double)keys.size();
+    sink_total = sink_total + sink;
+    printf("%s,int64,8,%.3f,%.3f\n", name, seconds * 1e9 / hashes, hashes * 8 / seconds / 1e9);
+}
+
+template <typename Hash>
+void throughput_strings(const char *name, size_t length, size_t total_bytes, mt19937_64 &gen)
+{
+    // about 1 MB of keys, so that the hash and not the memory bandwidth is measured
+    size_t count = max<size_t>(1, min<size_t>(100000, (1 << 20) / length));
+    vector<string> keys(count);
+    for (auto &k : keys)
+    {
+        k.resize(length);
+        for (auto &c : k) c = (char)('a' + gen() % 26);
+    }
+    Hash h;
+    size_t sink = 0, reps = max<size_t>(1, total_bytes / (count * length));
+    auto start = chrono::steady_clock::now();
+    for (size_t rep = 0; rep < reps; rep++)
+    {
+        for (auto &k : keys)
+        {
+            sink += h(string_view(k));
+        }
+    }
+    double seconds = seconds_since(start);
+    double hashes = (double)(reps * count);
+    sink_total = sink_total + sink;
+    printf("%s,string,%zu,%.3f,%.3f\n", name, length, seconds * 1e9 / hashes, hashes * (double)length / seconds / 1e9);
+}
+
+template <typename Key, typename Hash, typename BucketPolicy>
+void chains(const char *hash_name, const char *keys_name, const char *policy, const vector<Key> &keys)
+{
+    HashTable<Key, int, Hash, equal_to<Key>, BucketPolicy, allocator<pair<const Key, int>>, HashTableStats> table;
+    for (auto &k : keys)
+    {
+        table.insert(k, 0);
+    }
+    table.resetStats();
+    for (auto &k : keys)
+    {
+        table.find(k);
+    }
+    HashTableStatsReport report = table.getStats();
+    printf("%s,%s,%s,%zu,%zu,%.5f,%.3f\n", hash_name, keys_name, policy, keys.size(),
+           report.maxChainLength, report.hotBucketFraction, report.averageSuccessfulProbes);
+    fflush(stdout);
+}
+
+template <typename Key, typename Hash>
+void chains_all_policies(const char *hash_name, const char *keys_name, const vector<Key> &keys)
+{
+    chains<Key, Hash, PrimeBucketPolicy>(hash_name, keys_name, "prime", keys);
+    chains<Key, Hash, PowerOfTwoBucketPolicy>(hash_name, keys_name, "power_of_two", keys);
+    chains<Key, Hash, MaskBucketPolicy>(hash_name, keys_name, "mask", keys);
+}
+
+int main(int argc, char *argv[])
+{
+    size_t n = argc > 1 ? strtoul(argv[1], nullptr, 10) : 1000000;
+    unsigned long seed = argc > 2 ? strtoul(argv[2], nullptr, 10) : 281;
+    mt19937_64 gen(seed);
+
+    vector<long> random_keys(n), sequential_keys(n), strided_keys(n);
+    for (size_t i = 0; i < n; i++)
+    {
+        random_keys[i] = (long)gen();
+        sequential_keys[i] = (long)i;
+        strided_keys[i] = (long)(i << 12);
+    }
+
+    printf("hash,keys,length,ns_per_hash,gb_per_s\n");
+    throughput_integers<std_hash>("std::hash", random_keys);
+    throughput_integers<IntegerHash>("IntegerHash", random_keys);
+    throughput_integers<SeededHash>("SeededHash", random_keys);
+    for (size_t length : {8, 16, 32, 64, 256, 1024, 4096})
+    {
+        throughput_strings<std_hash>("std::hash", length, 256 << 20, gen);
+        throughput_strings<FastStringHash>("FastStringHash", length, 256 << 20, gen);
+        throughput_strings<SeededHash>("SeededHash", length, 256 << 20, gen);
+    }
+
+    printf("\nhash,keys,policy,n,max_chain,hot_fraction,average_probes\n");
+    const pair<const char *, const vector<long> *> integer_sets[] = {
+        {"random", &random_keys},
+        {"sequential", &sequential_keys},
+        {"strided", &strided_keys},
+    };
+    for (auto &set : integer_sets)
+    {
+        chains_all_policies<long, std_hash>("std::hash", set.first, *set.second);
+        chains_all_policies<long, IntegerHash>("IntegerHash", set.first, *set.second);
+        chains_all_policies<long, SeededHash>("SeededHash", set.first, *set.second);
+    }
+    // keys of the form "user:<id>", sharing a prefix and differing in a few bytes
+    vector<string> string_keys(n);
+    for (size_t i = 0; i < n; i++)
+    {
+        string_keys[i] = "user:" + to_string(i);
+    }
+    chains_all_policies<string, std_hash>("std::hash", "user_ids", string_keys);
+    chains_all_policies<string, FastStringHash>("FastStringHash", "user_ids", string_keys);
+    chains_all_policies<string, SeededHash>("SeededHash", "user_ids", string_keys);
+    return 0;
+}
@@ -1,5 +1,8 @@
 // adopted from /usr/include/c++/10.2.0/ext/pb_ds/detail/resize_policy/hash_prime_size_policy_imp.hpp
+#ifndef VE281P2_HASH_PRIME_HPP
+#define VE281P2_HASH_PRIME_HPP
 
+#include <cstdint>
 #include <utility>
 
 namespace HashPrime {
@@ -77,4 +80,31 @@ namespace HashPrime {
         /* 61    */ (std::size_t)18446744073709551557ull,
     };
 
+    __extension__ typedef unsigned __int128 uint128_t;
+
+    /**
+     * Lemire's fastmod: with M = ceil(2^128 / d), a % d == ((M * a mod 2^128) * d) >> 128
+     * for every 64-bit a and d, which costs three multiplications instead of a division
+     */
+    struct FastModTable {
+        uint128_t magic[num_distinct_sizes_64_bit];
+
+        constexpr FastModTable() : magic() {
+            for (std::size_t i = 0; i < num_distinct_sizes_64_bit; i++) {
+                magic[i] = ~(uint128_t)0 / (uint64_t)g_a_sizes[i] + 1;
+            }
+        }
+    };
+
+    static constexpr FastModTable g_a_fastmod{};
+
+    inline std::size_t fastmod(uint64_t a, uint128_t magic, uint64_t d) {
+        uint128_t lowBits = magic * a;
+        uint128_t bottom = ((lowBits & UINT64_MAX) * d) >> 64;
+        uint128_t top = (lowBits >> 64) * d;
+        return (std::size_t)((bottom + top) >> 64);
+    }
+
 }
+
+#endif //VE281P2_HASH_PRIME_HPP
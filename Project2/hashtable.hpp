@@ -1,8 +1,21 @@
-#include "hash_prime.hpp"
+#ifndef VE281P2_HASHTABLE_HPP
+#define VE281P2_HASHTABLE_HPP
+#include "bucket_policy.hpp"
+#include "hashtable_filter.hpp"
+#include "hashtable_stats.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
 #include <exception>
 #include <forward_list>
 #include <functional>
+#include <iterator>
 #include <math.h>
+#include <memory>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
 #include <vector>
 #include <iostream> // FIXME: delete this
 /**
@@ -14,18 +27,44 @@
  * @tparam Value        data type
  * @tparam Hash         function object, return the hash value of a key
  * @tparam KeyEqual     function object, return whether two keys are the same
+ * @tparam BucketPolicy allowed bucket counts and the hash value to bucket mapping, see bucket_policy.hpp
+ * @tparam Allocator    allocator of the nodes, e.g. PoolAllocator in pool_allocator.hpp
+ * @tparam Stats        HashTableStats to record lookup probes and rehashes, see hashtable_stats.hpp
+ * @tparam Filter       BlockedBloomFilter to answer lookups of absent keys without the buckets, see hashtable_filter.hpp
  */
 template <
     typename Key, typename Value,
     typename Hash = std::hash<Key>,
-    typename KeyEqual = std::equal_to<Key>
+    typename KeyEqual = std::equal_to<Key>,
+    typename BucketPolicy = PrimeBucketPolicy,
+    typename Allocator = std::allocator<std::pair<const Key, Value>>,
+    typename Stats = NoHashTableStats,
+    typename Filter = NoHashTableFilter
 >
 class HashTable
 {
 public:
     typedef std::pair<const Key, Value> HashNode;
-    typedef std::forward_list<HashNode> HashNodeList;
+
+    /**
+     * An element of a bucket list: the node and the full hash value of its key
+     * The hash is cached so that a rehash does not recompute it,
+     * and a chain walk compares it before calling KeyEqual
+     */
+    struct StoredNode
+    {
+        size_t hashValue;
+        HashNode node;
+
+        template <typename... Args>
+        StoredNode(size_t hashValue, Args&&... args) :
+            hashValue(hashValue), node(std::forward<Args>(args)...) {}
+    };
+
+    typedef typename std::allocator_traits<Allocator>::template rebind_alloc<StoredNode> NodeAllocator;
+    typedef std::forward_list<StoredNode, NodeAllocator> HashNodeList;
     typedef std::vector<HashNodeList> HashTableData;
+    typedef std::vector<uint64_t> OccupancyBitmap; // bit i is set if and only if bucket i is not empty
     typedef typename HashTableData::iterator VectorIterator;
     typedef typename HashNodeList::iterator ListIterator;
     /**
@@ -38,10 +77,50 @@ public:
         typedef typename HashTableData::iterator VectorIterator;
         typedef typename HashNodeList::iterator ListIterator;
 
-        const HashTable* hashTable;
+        HashTable* hashTable;
         VectorIterator bucketIt;   // an iterator of the buckets
         ListIterator listItBefore; // a before iterator of the list, here we use "before" for quick erase and insert
         bool endFlag = false;      // whether it is an end iterator
+        bool inOld = false;        // whether bucketIt points into oldBuckets (during an incremental resize)
+        size_t hashValue = 0;      // hash of the key find was looking for
+
+        HashTableData& data() const
+        {
+            return inOld ? hashTable->oldBuckets : hashTable->buckets;
+        }
+
+        const OccupancyBitmap& bits() const
+        {
+            return inOld ? hashTable->oldOccupied : hashTable->occupied;
+        }
+
+        /**
+         * Move to the first element of the first non-empty bucket at or after bucketIt
+         * Empty buckets are skipped a word of the occupancy bitmap at a time
+         * The buckets not yet migrated by an incremental resize are visited after buckets
+         */
+        void settle()
+        {
+            while (true)
+            {
+                size_t index = nextOccupied(bits(), (size_t)(bucketIt - data().begin()), data().size());
+                bucketIt = data().begin() + (long)index;
+                if (bucketIt != data().end())
+                {
+                    // begin() starts at the end of empty new buckets when every node is still old
+                    endFlag = false;
+                    listItBefore = bucketIt->before_begin();
+                    return;
+                }
+                if (inOld || !hashTable->isRehashing())
+                {
+                    endFlag = true;
+                    return;
+                }
+                inOld = true;
+                bucketIt = hashTable->oldBuckets.begin() + (long)hashTable->migrateIndex;
+            }
+        }
 
         /**
          * Increment the iterator
@@ -49,7 +128,7 @@ public:
          */
         void increment()
         {
-            if (bucketIt == hashTable->buckets.end())
+            if (bucketIt == data().end())
             {
                 endFlag = true;
                 return;
@@ -65,28 +144,15 @@ public:
                     return;
                 }
             }
-            while (++bucketIt != hashTable->buckets.end())
-            {
-                if (!bucketIt->empty())
-                {
-                    // use the first element in a new forward_list
-                    listItBefore = bucketIt->before_begin();
-                    return;
-                }
-            }
-            endFlag = true;
-        }
-
-        explicit Iterator(HashTable* hashTable) : hashTable(hashTable)
-        {
-            bucketIt = hashTable->buckets.begin();
-            listItBefore = bucketIt->before_begin();
-            endFlag = bucketIt == hashTable->buckets.end();
+            // use the first element in a new forward_list
+            ++bucketIt;
+            settle();
         }
 
-        Iterator(HashTable* hashTable, VectorIterator vectorIt, ListIterator listItBefore) : hashTable(hashTable), bucketIt(vectorIt), listItBefore(listItBefore)
+        Iterator(HashTable* hashTable, VectorIterator vectorIt, ListIterator listItBefore, bool inOld = false) :
+            hashTable(hashTable), bucketIt(vectorIt), listItBefore(listItBefore), inOld(inOld)
         {
-            endFlag = bucketIt == hashTable->buckets.end();
+            endFlag = bucketIt == data().end();
         }
 
     public:
@@ -115,6 +181,8 @@ public:
         {
             if (endFlag && that.endFlag)
                 return true;
+            if (endFlag != that.endFlag || inOld != that.inOld)
+                return false;
             if (bucketIt != that.bucketIt)
                 return false;
             return listItBefore == that.listItBefore;
@@ -122,49 +190,50 @@ public:
 
         bool operator!=(const Iterator& that) const
         {
-            if (endFlag && that.endFlag)
-                return false;
-            if (bucketIt != that.bucketIt)
-                return true;
-            return listItBefore != that.listItBefore;
+            return !(*this == that);
         }
 
         HashNode* operator->()
         {
             auto listIt = listItBefore;
             ++listIt;
-            return &(*listIt);
+            return &listIt->node;
         }
 
         HashNode& operator*()
         {
             auto listIt = listItBefore;
             ++listIt;
-            return *listIt;
+            return listIt->node;
         }
     };
 
 protected:                                                                 // DO NOT USE private HERE!
     static constexpr double DEFAULT_LOAD_FACTOR = 0.5;                     // default maximum load factor is 0.5
     static constexpr size_t DEFAULT_BUCKET_SIZE = HashPrime::g_a_sizes[0]; // default number of buckets is 5
+    static constexpr size_t DEFAULT_MIGRATION_STEP = 4;                    // buckets migrated per operation
+    static constexpr size_t DEFAULT_PREFETCH_DISTANCE = 8;                 // keys prefetched ahead by batch operations
+    static constexpr size_t BULK_PARALLEL_THRESHOLD = 16384;               // smaller bulk loads run on one thread
 
+    Allocator allocator;                            // shared by the lists of every bucket
     HashTableData buckets;                          // buckets, of singly linked lists
-    typename HashTableData::iterator firstBucketIt; // help get begin iterator in O(1) time
+    typename HashTableData::iterator firstBucketIt; // every bucket before it is empty, help get begin iterator fast
+    HashTableData oldBuckets;                       // buckets being migrated by an incremental resize
+    OccupancyBitmap occupied;                       // which buckets are not empty
+    OccupancyBitmap oldOccupied;                    // which oldBuckets are not empty
+    size_t migrateIndex = 0;                        // oldBuckets before this index are already migrated
+    bool incrementalRehash = false;                 // whether resizes are spread over later operations
+    size_t migrationStep = DEFAULT_MIGRATION_STEP;  // number of old buckets migrated per operation
+    size_t prefetchDistance = DEFAULT_PREFETCH_DISTANCE; // number of keys prefetched ahead by batch operations
+    BucketPolicy policy;                            // maps hash values to buckets
+    BucketPolicy oldPolicy;                         // maps hash values to oldBuckets
     size_t tableSize;     // number of elements
     double maxLoadFactor; // maximum load factor
+    double minLoadFactor = 0; // erasing a key below it shrinks the table, 0 never shrinks
     Hash hash;            // hash function instance
     KeyEqual keyEqual;    // key equal function instance
-
-    /**
- * Time Complexity: O(k)
- * @param key
- * @param bucketSize
- * @return the hash value of key with a new bucket size
- */
-    inline size_t hashKey(const Key& key, size_t bucketSize) const
-    {
-        return hash(key) % bucketSize;
-    }
+    Stats stats;          // lookup and rehash counters, empty unless Stats = HashTableStats
+    Filter filter;        // holds the hash of every key, empty unless Filter = BlockedBloomFilter
 
     /**
  * Time Complexity: O(k)
@@ -173,7 +242,7 @@ protected:                                                                 // DO
  */
     inline size_t hashKey(const Key& key) const
     {
-        return hash(key) % buckets.size();
+        return policy.bucket(hash(key));
     }
 
     /**
@@ -181,7 +250,7 @@ protected:                                                                 // DO
  * The minimum bucket size must satisfy all of the following requirements:
  * - It is not less than (i.e. greater or equal to) the parameter bucketSize
  * - It is greater than floor(tableSize / maxLoadFactor)
- * - It is a (prime) number defined in HashPrime (hash_prime.hpp)
+ * - It is a number allowed by BucketPolicy (a prime in hash_prime.hpp by default)
  * - It is minimum if satisfying all other requirements
  * Time Complexity: O(1)
  * @throw std::range_error if no such bucket size can be found
@@ -190,70 +259,461 @@ protected:                                                                 // DO
     size_t findMinimumBucketSize(size_t bucketSize) const
     {
         size_t thisMaxLoad = (size_t)floor((double)tableSize / maxLoadFactor);
-        for (size_t i = 0; i < HashPrime::num_distinct_sizes; i++)
+        return BucketPolicy::roundUp(std::max(bucketSize, thisMaxLoad + 1));
+    }
+
+    /**
+     * The filter is sized for the number of keys bucketSize buckets hold before growing
+     */
+    size_t filterCapacity(size_t bucketSize) const
+    {
+        return std::max(tableSize, (size_t)floor((double)bucketSize * maxLoadFactor) + 1);
+    }
+
+    /**
+     * Refill the filter from the cached hash values, outside of an incremental resize
+     * Time Complexity: O(n + bucketSize / 64)
+     */
+    void rebuildFilter()
+    {
+        if constexpr (Filter::enabled)
+        {
+            filter.reset(filterCapacity(buckets.size()));
+            for (size_t i = nextOccupied(occupied, 0, buckets.size()); i < buckets.size();
+                 i = nextOccupied(occupied, i + 1, buckets.size()))
+            {
+                for (auto& stored : buckets[i])
+                {
+                    filter.add(stored.hashValue);
+                }
+            }
+        }
+    }
+
+    /**
+     * Find the node before key in a bucket
+     * Time Complexity: O(chain length)
+     * @param hashValue the hash of key, compared before calling keyEqual
+     * @param probes incremented by the number of nodes visited
+     * @return the before iterator of key, or list.end() if key is not in list
+     */
+    template <typename K>
+    ListIterator findBefore(HashNodeList& list, const K& key, size_t hashValue, size_t& probes) const
+    {
+        for (ListIterator listIt = list.before_begin(), nextIt = list.begin(); nextIt != list.end(); listIt = nextIt++)
         {
-            if (HashPrime::g_a_sizes[i] >= bucketSize && HashPrime::g_a_sizes[i] > thisMaxLoad)
+            probes++;
+            if (nextIt->hashValue == hashValue && keyEqual(nextIt->node.first, key))
             {
-                return HashPrime::g_a_sizes[i];
+                return listIt;
             }
         }
-        throw std::range_error("No such bucket size");
+        return list.end();
+    }
+
+    static OccupancyBitmap makeBitmap(size_t bucketSize)
+    {
+        return OccupancyBitmap((bucketSize + 63) / 64, 0);
     }
 
-    // TODO: define your helper functions here if necessary
+    static void setOccupied(OccupancyBitmap& bits, size_t index)
+    {
+        bits[index >> 6] |= (uint64_t)1 << (index & 63);
+    }
 
-public:
-    HashTable() : buckets(DEFAULT_BUCKET_SIZE), tableSize(0), maxLoadFactor(DEFAULT_LOAD_FACTOR),
-        hash(Hash()), keyEqual(KeyEqual())
+    static void clearOccupied(OccupancyBitmap& bits, size_t index)
+    {
+        bits[index >> 6] &= ~((uint64_t)1 << (index & 63));
+    }
+
+    /**
+     * Time Complexity: O((result - first) / 64)
+     * @return the first non-empty bucket in [first, last), or last if there is none
+     */
+    static size_t nextOccupied(const OccupancyBitmap& bits, size_t first, size_t last)
+    {
+        if (first >= last) return last;
+        size_t word = first >> 6;
+        uint64_t w = bits[word] & (~(uint64_t)0 << (first & 63));
+        while (w == 0)
+        {
+            if (++word << 6 >= last) return last;
+            w = bits[word];
+        }
+        return std::min(last, (word << 6) + (size_t)__builtin_ctzll(w));
+    }
+
+    /**
+     * Every list is constructed with the allocator of the table,
+     * so that nodes can be spliced between any two buckets
+     * Time Complexity: O(bucketSize)
+     */
+    HashTableData makeBuckets(size_t bucketSize) const
+    {
+        HashTableData data;
+        data.reserve(bucketSize);
+        for (size_t i = 0; i < bucketSize; i++)
+        {
+            data.emplace_back(NodeAllocator(allocator));
+        }
+        return data;
+    }
+
+    /**
+     * Copy the nodes of another table into lists using the allocator of this table
+     * Time Complexity: O(n + bucketSize)
+     */
+    HashTableData copyBuckets(const HashTableData& that) const
     {
+        HashTableData data = makeBuckets(that.size());
+        for (size_t i = 0; i < that.size(); i++)
+        {
+            data[i].insert_after(data[i].before_begin(), that[i].begin(), that[i].end());
+        }
+        return data;
+    }
+
+    /**
+     * Return the memory of freed nodes in bulk, if the allocator supports it
+     */
+    template <typename A>
+    static auto releaseNodes(A& alloc, int) -> decltype(alloc.release(), void())
+    {
+        alloc.release();
+    }
+
+    template <typename A>
+    static void releaseNodes(A&, long) {}
+
+    /**
+     * Start an incremental resize: the current buckets become oldBuckets
+     * and their nodes are relinked into the new buckets by migrate
+     * Time Complexity: O(newBucketSize)
+     */
+    void startResize(size_t newBucketSize)
+    {
+        std::chrono::steady_clock::time_point start;
+        if constexpr (Stats::enabled) start = std::chrono::steady_clock::now();
+        oldBuckets.swap(buckets);
+        buckets = makeBuckets(newBucketSize);
+        oldOccupied.swap(occupied);
+        occupied = makeBitmap(newBucketSize);
+        oldPolicy = policy;
+        policy.reset(newBucketSize);
+        // refilled by migrate, and not probed until the migration finishes
+        filter.reset(filterCapacity(newBucketSize));
+        migrateIndex = 0;
         firstBucketIt = buckets.end();
+        if constexpr (Stats::enabled)
+        {
+            stats.recordRehash(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        }
     }
 
-    explicit HashTable(size_t bucketSize) : tableSize(0), maxLoadFactor(DEFAULT_LOAD_FACTOR),
-        hash(Hash()), keyEqual(KeyEqual())
+    /**
+     * Relink the nodes of up to count old buckets into the new buckets, no node is copied
+     * Time Complexity: O(count + number of nodes moved)
+     */
+    void migrate(size_t count)
     {
-        bucketSize = findMinimumBucketSize(bucketSize);
-        buckets.resize(bucketSize);
+        if (oldBuckets.empty()) return;
+        std::chrono::steady_clock::time_point start;
+        if constexpr (Stats::enabled) start = std::chrono::steady_clock::now();
+        for (; count > 0 && migrateIndex < oldBuckets.size(); count--, migrateIndex++)
+        {
+            HashNodeList& from = oldBuckets[migrateIndex];
+            while (!from.empty())
+            {
+                VectorIterator to = buckets.begin() + (long)policy.bucket(from.front().hashValue);
+                filter.add(from.front().hashValue);
+                to->splice_after(to->before_begin(), from, from.before_begin());
+                setOccupied(occupied, (size_t)(to - buckets.begin()));
+                if (to < firstBucketIt) firstBucketIt = to;
+            }
+            clearOccupied(oldOccupied, migrateIndex);
+        }
+        if (migrateIndex == oldBuckets.size() && !oldBuckets.empty())
+        {
+            HashTableData().swap(oldBuckets);
+            OccupancyBitmap().swap(oldOccupied);
+            migrateIndex = 0;
+        }
+        if constexpr (Stats::enabled)
+        {
+            stats.recordRehashTime(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        }
+    }
+
+    void finishMigration()
+    {
+        migrate(oldBuckets.size());
+    }
+
+    /**
+     * Called when the load factor exceeds its maximum after an insertion
+     */
+    void grow()
+    {
+        if (incrementalRehash)
+        {
+            finishMigration();
+            startResize(findMinimumBucketSize(buckets.size()));
+        }
+        else
+        {
+            rehash(buckets.size());
+        }
+    }
+
+    /**
+     * Called after erasing a key: if the load factor fell below its minimum, resize so that it is
+     * about half the maximum again, which is at least twice the minimum (see setMinLoadFactor),
+     * so the table has to lose or gain half of its keys before the next resize
+     * Time Complexity: O(1), Amortized O(1) with a resize
+     */
+    void shrinkIfSparse()
+    {
+        if (minLoadFactor <= 0 || isRehashing() || loadFactor() >= minLoadFactor) return;
+        size_t newBucketSize = findMinimumBucketSize(std::max(BucketPolicy::roundUp(DEFAULT_BUCKET_SIZE),
+                                                              (size_t)floor(2 * (double)tableSize / maxLoadFactor)));
+        if (newBucketSize >= buckets.size()) return;
+        if (incrementalRehash)
+        {
+            startResize(newBucketSize);
+        }
+        else
+        {
+            rehash(newBucketSize);
+        }
+    }
+
+    /**
+     * Steal the state of that, whose nodes this allocator can free, then leave that empty
+     * The bucket arrays are moved, so firstBucketIt keeps its position
+     */
+    void moveFrom(HashTable& that) noexcept
+    {
+        auto first = that.firstBucketIt - that.buckets.begin();
+        buckets = std::move(that.buckets);
+        firstBucketIt = buckets.begin() + first;
+        oldBuckets = std::move(that.oldBuckets);
+        occupied = std::move(that.occupied);
+        oldOccupied = std::move(that.oldOccupied);
+        migrateIndex = that.migrateIndex;
+        incrementalRehash = that.incrementalRehash;
+        migrationStep = that.migrationStep;
+        prefetchDistance = that.prefetchDistance;
+        policy = that.policy;
+        oldPolicy = that.oldPolicy;
+        tableSize = that.tableSize;
+        maxLoadFactor = that.maxLoadFactor;
+        minLoadFactor = that.minLoadFactor;
+        hash = std::move(that.hash);
+        keyEqual = std::move(that.keyEqual);
+        stats = std::move(that.stats);
+        filter = std::move(that.filter);
+        that.dropBuckets();
+    }
+
+    /**
+     * Leave the table empty and without any bucket, as after a move
+     * allocateIfMoved gives it buckets again on its next use
+     */
+    void dropBuckets() noexcept
+    {
+        HashTableData().swap(buckets);
+        HashTableData().swap(oldBuckets);
+        OccupancyBitmap().swap(occupied);
+        OccupancyBitmap().swap(oldOccupied);
         firstBucketIt = buckets.end();
+        migrateIndex = 0;
+        tableSize = 0;
     }
 
-    HashTable(const HashTable& that)
+    /**
+     * Replace the (empty) buckets by bucketSize new ones
+     * Time Complexity: O(bucketSize)
+     */
+    void allocateBuckets(size_t bucketSize)
     {
-        // FIXME: 
-        buckets = std::vector<HashNodeList>(that.buckets);
+        buckets = makeBuckets(bucketSize);
+        occupied = makeBitmap(bucketSize);
+        policy.reset(bucketSize);
+        filter.reset(filterCapacity(bucketSize));
         firstBucketIt = buckets.end();
+    }
+
+    /**
+     * Called before anything indexes the buckets: a moved-from table gets the default number of buckets
+     * Time Complexity: O(1)
+     */
+    void allocateIfMoved()
+    {
+        if (buckets.empty())
+        {
+            allocateBuckets(BucketPolicy::roundUp(DEFAULT_BUCKET_SIZE));
+        }
+    }
+
+public:
+    HashTable() : tableSize(0), maxLoadFactor(DEFAULT_LOAD_FACTOR),
+        hash(Hash()), keyEqual(KeyEqual())
+    {
+        allocateBuckets(BucketPolicy::roundUp(DEFAULT_BUCKET_SIZE));
+    }
+
+    explicit HashTable(size_t bucketSize, const Allocator& alloc = Allocator()) : allocator(alloc),
+        tableSize(0), maxLoadFactor(DEFAULT_LOAD_FACTOR), hash(Hash()), keyEqual(KeyEqual())
+    {
+        allocateBuckets(findMinimumBucketSize(bucketSize));
+    }
+
+    /**
+ * Construct a hashtable of the pairs in [first, last), see bulkLoad
+ * The buckets are sized once instead of growing through every bucket size,
+ * and the elements are linked in parallel by bucket range
+ * Time Complexity: O(nk + bucketSize)
+ * @param threads number of threads
+ */
+    template <typename InputIt, typename = typename std::iterator_traits<InputIt>::iterator_category>
+    HashTable(InputIt first, InputIt last, unsigned threads = std::thread::hardware_concurrency(),
+              const Allocator& alloc = Allocator()) : allocator(alloc),
+        tableSize(0), maxLoadFactor(DEFAULT_LOAD_FACTOR), hash(Hash()), keyEqual(KeyEqual())
+    {
+        if constexpr (std::is_base_of<std::random_access_iterator_tag,
+                      typename std::iterator_traits<InputIt>::iterator_category>::value)
+        {
+            bulkLoad(first, (size_t)(last - first), threads);
+        }
+        else
+        {
+            std::vector<std::pair<Key, Value>> elements(first, last);
+            bulkLoad(elements.begin(), elements.size(), threads);
+        }
+    }
+
+    HashTable(const HashTable& that)
+        : allocator(std::allocator_traits<Allocator>::select_on_container_copy_construction(that.allocator))
+    {
+        buckets = copyBuckets(that.buckets);
+        firstBucketIt = buckets.begin() + (that.firstBucketIt - that.buckets.begin());
+        oldBuckets = copyBuckets(that.oldBuckets);
+        occupied = that.occupied;
+        oldOccupied = that.oldOccupied;
+        migrateIndex = that.migrateIndex;
+        incrementalRehash = that.incrementalRehash;
+        migrationStep = that.migrationStep;
+        prefetchDistance = that.prefetchDistance;
+        policy = that.policy;
+        oldPolicy = that.oldPolicy;
         tableSize = that.tableSize;
         maxLoadFactor = that.maxLoadFactor;
+        minLoadFactor = that.minLoadFactor;
         hash = that.hash;
         keyEqual = that.keyEqual;
+        stats = that.stats;
+        filter = that.filter;
     }
 
     HashTable& operator=(const HashTable& that)
     {
-        // FIXME: 
-        buckets = std::vector<HashNodeList>(that.buckets);
-        firstBucketIt = buckets.end();
+        if (this == &that) return *this;
+        HashTableData().swap(buckets);
+        HashTableData().swap(oldBuckets);
+        if (std::allocator_traits<Allocator>::propagate_on_container_copy_assignment::value)
+        {
+            allocator = that.allocator;
+        }
+        buckets = copyBuckets(that.buckets);
+        firstBucketIt = buckets.begin() + (that.firstBucketIt - that.buckets.begin());
+        oldBuckets = copyBuckets(that.oldBuckets);
+        occupied = that.occupied;
+        oldOccupied = that.oldOccupied;
+        migrateIndex = that.migrateIndex;
+        incrementalRehash = that.incrementalRehash;
+        migrationStep = that.migrationStep;
+        prefetchDistance = that.prefetchDistance;
+        policy = that.policy;
+        oldPolicy = that.oldPolicy;
         tableSize = that.tableSize;
         maxLoadFactor = that.maxLoadFactor;
+        minLoadFactor = that.minLoadFactor;
         hash = that.hash;
         keyEqual = that.keyEqual;
+        stats = that.stats;
+        filter = that.filter;
         return *this;
     };
 
+    /**
+     * Take the buckets and nodes of that, which is left empty and without any bucket:
+     * it allocates the default number of buckets again when it is next used
+     * that keeps a copy of the allocator, so with PoolAllocator both tables share one pool
+     * until that is destroyed or assigned; nodes inserted into that later come from the same pool,
+     * and release (by clear) returns no chunk while either table holds a node
+     * Time Complexity: O(1)
+     */
+    HashTable(HashTable&& that) noexcept : allocator(that.allocator), buckets(std::move(that.buckets)),
+        firstBucketIt(that.firstBucketIt), oldBuckets(std::move(that.oldBuckets)),
+        occupied(std::move(that.occupied)), oldOccupied(std::move(that.oldOccupied)),
+        migrateIndex(that.migrateIndex), incrementalRehash(that.incrementalRehash),
+        migrationStep(that.migrationStep), prefetchDistance(that.prefetchDistance),
+        policy(that.policy), oldPolicy(that.oldPolicy), tableSize(that.tableSize),
+        maxLoadFactor(that.maxLoadFactor), minLoadFactor(that.minLoadFactor),
+        hash(std::move(that.hash)), keyEqual(std::move(that.keyEqual)),
+        stats(std::move(that.stats)), filter(std::move(that.filter))
+    {
+        that.dropBuckets();
+    }
+
+    /**
+     * Take the buckets and nodes of that, unless the allocators differ and do not propagate on move
+     * (then the nodes are copied into this allocator, as by the copy assignment, which may throw)
+     * Either way, that is left as by the move constructor
+     * Time Complexity: O(n) to free the elements of this, O(1) to take those of that
+     */
+    HashTable& operator=(HashTable&& that) noexcept(
+        std::allocator_traits<Allocator>::propagate_on_container_move_assignment::value
+        || std::allocator_traits<Allocator>::is_always_equal::value)
+    {
+        if (this == &that) return *this;
+        if (!std::allocator_traits<Allocator>::propagate_on_container_move_assignment::value
+            && !(allocator == that.allocator))
+        {
+            *this = static_cast<const HashTable&>(that);
+            that.clear();
+            that.dropBuckets();
+            return *this;
+        }
+        HashTableData().swap(buckets);
+        HashTableData().swap(oldBuckets);
+        if (std::allocator_traits<Allocator>::propagate_on_container_move_assignment::value)
+        {
+            allocator = that.allocator;
+        }
+        moveFrom(that);
+        return *this;
+    }
+
     ~HashTable() = default;
 
+    /**
+     * Time Complexity: amortized O(1), firstBucketIt is moved to the first non-empty bucket
+     */
     Iterator begin()
     {
-        if (firstBucketIt != buckets.end())
+        Iterator it(this, firstBucketIt, ListIterator());
+        it.settle();
+        if (!it.inOld)
         {
-            return Iterator(this, firstBucketIt, firstBucketIt->before_begin());
+            firstBucketIt = it.bucketIt;
         }
-        return end();
+        return it;
     }
 
     Iterator end()
     {
-        return Iterator(this, buckets.end(), buckets.begin()->before_begin());
+        return Iterator(this, buckets.end(), ListIterator());
     }
 
     /**
@@ -271,34 +731,542 @@ public:
  * Find the value in hashtable by key
  * If the key exists, iterator points to the corresponding value, and it.endFlag = false
  * Otherwise, iterator points to the place that the key were to be inserted, and it.endFlag = true
+ * During an incremental resize, migrate some old buckets first, then look in both bucket arrays
+ * (so any find may invalidate iterators while a resize is in progress)
  * Time Complexity: Amortized O(k)
  * @param key
  * @return a pair (success, iterator of the value)
  */
     Iterator find(const Key& key)
     {
-        // FIXME: implement this function
-        size_t position;
-        position = (size_t) hashKey(key, buckets.size());
-        VectorIterator vecIt = buckets.begin() + (long)position;
-        for (ListIterator listIt=vecIt->before_begin();listIt!=vecIt->end();++listIt)
+        allocateIfMoved();
+        if (isRehashing())
+        {
+            migrate(migrationStep);
+        }
+        return findHashed(key, hash(key));
+    }
+
+    /**
+ * Heterogeneous versions of find, contains, erase and operator[]
+ * They are only enabled when both Hash and KeyEqual define is_transparent, e.g. StringHash
+ * (hash_functions.hpp) with std::equal_to<>, so that a table of std::string can be searched
+ * by std::string_view or const char* without constructing a temporary std::string
+ * Time Complexity: Amortized O(k)
+ */
+    template <typename K, typename H = Hash, typename E = KeyEqual,
+              typename = typename H::is_transparent, typename = typename E::is_transparent>
+    Iterator find(const K& key)
+    {
+        allocateIfMoved();
+        if (isRehashing())
+        {
+            migrate(migrationStep);
+        }
+        return findHashed(key, hash(key));
+    }
+
+    template <typename K, typename H = Hash, typename E = KeyEqual,
+              typename = typename H::is_transparent, typename = typename E::is_transparent>
+    bool contains(const K& key)
+    {
+        return !find(key).endFlag;
+    }
+
+    template <typename K, typename H = Hash, typename E = KeyEqual,
+              typename = typename H::is_transparent, typename = typename E::is_transparent>
+    bool erase(const K& key)
+    {
+        Iterator it = find(key);
+        if (it.endFlag) return false;
+        erase(it);
+        shrinkIfSparse();
+        return true;
+    }
+
+    /**
+ * Key is constructed from key only if it has to be inserted
+ */
+    template <typename K, typename H = Hash, typename E = KeyEqual,
+              typename = typename H::is_transparent, typename = typename E::is_transparent>
+    Value& operator[](const K& key)
+    {
+        return tryEmplaceKey(key).first->second;
+    }
+
+    /**
+ * Find every key of a batch, out[i] is the same iterator as find(keys[i])
+ * The whole batch is hashed first, then the bucket of the key prefetchDistance ahead
+ * and the first node of the key prefetchDistance / 2 ahead are prefetched before each lookup,
+ * so the cache misses of different keys overlap
+ * During an incremental resize, the migration of all the finds is done before the first lookup,
+ * so the iterators in out stay valid
+ * Time Complexity: Amortized O(k) per key
+ * @param keys
+ * @param out cleared, then filled with one iterator per key
+ */
+    void findBatch(const std::vector<Key>& keys, std::vector<Iterator>& out)
+    {
+        allocateIfMoved();
+        if (isRehashing())
         {
-            auto listItCopy = listIt;
-            if (++listItCopy != vecIt->end()) {
-                if (keyEqual(listItCopy->first, key))
+            migrate(migrationStep * keys.size());
+        }
+        std::vector<size_t> hashValues = hashBatch(keys);
+        out.clear();
+        out.reserve(keys.size());
+        prefetchedLoop(hashValues, [&](size_t i) {
+            out.push_back(findHashed(keys[i], hashValues[i]));
+        });
+    }
+
+    /**
+ * Batch version of contains, see findBatch
+ * Time Complexity: Amortized O(k) per key
+ * @param keys
+ * @param out cleared, then out[i] is whether keys[i] exists
+ */
+    void containsBatch(const std::vector<Key>& keys, std::vector<char>& out)
+    {
+        allocateIfMoved();
+        if (isRehashing())
+        {
+            migrate(migrationStep * keys.size());
+        }
+        std::vector<size_t> hashValues = hashBatch(keys);
+        out.assign(keys.size(), false);
+        prefetchedLoop(hashValues, [&](size_t i) {
+            out[i] = !findHashed(keys[i], hashValues[i]).endFlag;
+        });
+    }
+
+    /**
+ * Insert every <key, value> of a batch in order, the same as calling insert on each of them
+ * The buckets are prefetched as in findBatch
+ * Time Complexity: Amortized O(k) per element
+ * @param elements
+ * @return the number of insertions that took place (keys that did not exist)
+ */
+    size_t insertBatch(const std::vector<std::pair<Key, Value>>& elements)
+    {
+        allocateIfMoved();
+        std::vector<size_t> hashValues(elements.size());
+        for (size_t i = 0; i < elements.size(); i++)
+        {
+            hashValues[i] = hash(elements[i].first);
+        }
+        size_t inserted = 0;
+        prefetchedLoop(hashValues, [&](size_t i) {
+            if (isRehashing())
+            {
+                migrate(migrationStep);
+            }
+            Iterator it = findHashed(elements[i].first, hashValues[i]);
+            inserted += insert(it, elements[i].first, elements[i].second);
+        });
+        return inserted;
+    }
+
+    /**
+ * Set how many keys ahead the batch operations prefetch, 0 disables prefetching
+ * @param distance
+ */
+    void setPrefetchDistance(size_t distance) { prefetchDistance = distance; }
+
+    size_t getPrefetchDistance() const { return prefetchDistance; }
+
+protected:
+    /**
+ * find without the migration step, for a key whose hash is already computed
+ * Time Complexity: O(k)
+ */
+    template <typename K>
+    Iterator findHashed(const K& key, size_t hashValue)
+    {
+        size_t probes = 0;
+        VectorIterator vecIt = buckets.begin() + (long)policy.bucket(hashValue);
+        if constexpr (Filter::enabled)
+        {
+            if (!isRehashing())
+            {
+                bool passed = filter.mayContain(hashValue);
+                filter.recordQuery(passed);
+                if (!passed)
                 {
-                    return Iterator(this, vecIt, listIt);
+                    if constexpr (Stats::enabled) stats.recordLookup(false, 0);
+                    return notFound(vecIt, hashValue);
                 }
             }
-            else{
-                break;
+        }
+        ListIterator listIt = findBefore(*vecIt, key, hashValue, probes);
+        if (listIt != vecIt->end())
+        {
+            if constexpr (Stats::enabled) stats.recordLookup(true, probes);
+            Iterator it(this, vecIt, listIt);
+            it.hashValue = hashValue;
+            return it;
+        }
+        if (isRehashing())
+        {
+            size_t oldPosition = oldPolicy.bucket(hashValue);
+            if (oldPosition >= migrateIndex)
+            {
+                VectorIterator oldIt = oldBuckets.begin() + (long)oldPosition;
+                listIt = findBefore(*oldIt, key, hashValue, probes);
+                if (listIt != oldIt->end())
+                {
+                    if constexpr (Stats::enabled) stats.recordLookup(true, probes);
+                    Iterator it(this, oldIt, listIt, true);
+                    it.hashValue = hashValue;
+                    return it;
+                }
             }
         }
-        Iterator it = Iterator(this, vecIt, vecIt->before_begin()); // vecIt is empty
+        if constexpr (Stats::enabled) stats.recordLookup(false, probes);
+        if constexpr (Filter::enabled)
+        {
+            if (!isRehashing()) filter.recordFalsePositive();
+        }
+        return notFound(vecIt, hashValue);
+    }
+
+    /**
+     * The iterator of a failed find: the end iterator, remembering where the key would be inserted
+     */
+    Iterator notFound(VectorIterator vecIt, size_t hashValue)
+    {
+        Iterator it = Iterator(this, vecIt, vecIt->before_begin());
         it.endFlag = true;
+        it.hashValue = hashValue;
         return it;
     }
 
+    std::vector<size_t> hashBatch(const std::vector<Key>& keys) const
+    {
+        std::vector<size_t> hashValues(keys.size());
+        for (size_t i = 0; i < keys.size(); i++)
+        {
+            hashValues[i] = hash(keys[i]);
+        }
+        return hashValues;
+    }
+
+    void prefetchBucket(size_t hashValue) const
+    {
+        __builtin_prefetch(&buckets[policy.bucket(hashValue)]);
+    }
+
+    void prefetchFirstNode(size_t hashValue) const
+    {
+        const HashNodeList& list = buckets[policy.bucket(hashValue)];
+        if (!list.empty())
+        {
+            __builtin_prefetch(&list.front());
+        }
+    }
+
+    /**
+ * Call resolve(i) for every i in order, prefetching for the keys ahead
+ * Time Complexity: O(n) plus resolve
+ */
+    template <typename Resolve>
+    void prefetchedLoop(const std::vector<size_t>& hashValues, Resolve resolve)
+    {
+        size_t n = hashValues.size(), distance = prefetchDistance;
+        for (size_t i = 0; i < std::min(n, distance); i++)
+        {
+            prefetchBucket(hashValues[i]);
+        }
+        for (size_t i = 0; i < n; i++)
+        {
+            if (distance > 0)
+            {
+                if (i + distance < n) prefetchBucket(hashValues[i + distance]);
+                if (i + distance / 2 < n) prefetchFirstNode(hashValues[i + distance / 2]);
+            }
+            resolve(i);
+        }
+    }
+
+    /**
+ * The iterator of a node in the table, found again by its address in the bucket of its cached hash
+ * Unlike findHashed, no key is compared and no lookup is recorded in stats or the filter
+ * Time Complexity: O(chain length)
+ * @param target a node linked in the table
+ */
+    Iterator locate(const StoredNode* target)
+    {
+        size_t hashValue = target->hashValue;
+        // the old bucket of the node is not migrated yet, see findHashed
+        bool inOld = isRehashing() && oldPolicy.bucket(hashValue) >= migrateIndex;
+        VectorIterator vecIt = inOld ? oldBuckets.begin() + (long)oldPolicy.bucket(hashValue)
+                                     : buckets.begin() + (long)policy.bucket(hashValue);
+        ListIterator listIt = vecIt->before_begin();
+        while (&*std::next(listIt) != target)
+        {
+            ++listIt;
+        }
+        Iterator it(this, vecIt, listIt, inOld);
+        it.hashValue = hashValue;
+        return it;
+    }
+
+    /**
+ * Account for the node just linked after it.listItBefore, then grow if needed
+ * Nodes are relinked (never copied) by a resize, so the node is located again by its address
+ * Time Complexity: O(1), Amortized O(1) with a resize
+ * @param it the iterator of the failed find the node was inserted at
+ * @return the iterator of the new node
+ */
+    Iterator finishInsert(Iterator it)
+    {
+        it.endFlag = false;
+        tableSize++;
+        filter.add(it.hashValue);
+        setOccupied(occupied, (size_t)(it.bucketIt - buckets.begin()));
+        if (it.bucketIt < firstBucketIt) firstBucketIt = it.bucketIt;
+        if ((double)tableSize >= maxLoadFactor * (double)buckets.size())
+        {
+            const StoredNode* node = &*std::next(it.listItBefore);
+            grow();
+            return locate(node);
+        }
+        return it;
+    }
+
+    /**
+ * tryEmplace for any key type accepted by find, Key is constructed from key only on insertion
+ */
+    template <typename K, typename... Args>
+    std::pair<Iterator, bool> tryEmplaceKey(K&& key, Args&&... args)
+    {
+        allocateIfMoved();
+        if (isRehashing())
+        {
+            migrate(migrationStep);
+        }
+        Iterator it = findHashed(key, hash(key));
+        if (!it.endFlag)
+        {
+            return std::make_pair(it, false);
+        }
+        it.bucketIt->emplace_after(it.listItBefore, it.hashValue, std::piecewise_construct,
+                                   std::forward_as_tuple(std::forward<K>(key)),
+                                   std::forward_as_tuple(std::forward<Args>(args)...));
+        return std::make_pair(finishInsert(it), true);
+    }
+
+    template <typename K, typename V>
+    std::pair<Iterator, bool> insertOrAssignKey(K&& key, V&& value)
+    {
+        allocateIfMoved();
+        if (isRehashing())
+        {
+            migrate(migrationStep);
+        }
+        Iterator it = findHashed(key, hash(key));
+        if (!it.endFlag)
+        {
+            std::next(it.listItBefore)->node.second = std::forward<V>(value);
+            return std::make_pair(it, false);
+        }
+        it.bucketIt->emplace_after(it.listItBefore, it.hashValue, std::forward<K>(key), std::forward<V>(value));
+        return std::make_pair(finishInsert(it), true);
+    }
+
+    /**
+ * Call f on every node of the non-empty buckets in [first, data.size()),
+ * split into ranges of whole bitmap words across threads
+ */
+    template <typename F>
+    static void forEachIn(HashTableData& data, const OccupancyBitmap& bits, size_t first, F& f, unsigned threads)
+    {
+        auto scan = [&](size_t from, size_t to) {
+            for (size_t i = nextOccupied(bits, from, to); i < to; i = nextOccupied(bits, i + 1, to))
+            {
+                for (auto& stored : data[i])
+                {
+                    f(stored.node);
+                }
+            }
+        };
+        size_t n = data.size();
+        if (threads == 0) threads = 1;
+        size_t chunk = ((n - std::min(n, first)) / threads + 63) / 64 * 64;
+        if (threads == 1 || chunk < 4096)
+        {
+            scan(first, n);
+            return;
+        }
+        std::vector<std::thread> workers;
+        for (size_t from = first; from < n; from += chunk)
+        {
+            workers.emplace_back(scan, from, std::min(n, from + chunk));
+        }
+        for (auto& w : workers) w.join();
+    }
+
+    /**
+ * Fill the empty hashtable with n elements (pairs of key and value) starting at first
+ * The buckets are sized once for n elements. With more than one thread, every element is hashed, the elements are
+ * grouped (stably) by the thread owning their bucket, and each thread links its elements into
+ * its own range of buckets, which covers whole words of the occupancy bitmap, so no locking is needed
+ * Threads are only used when the allocator is stateless (is_always_equal), e.g. not with PoolAllocator
+ * If a key appears more than once, the last value is kept, as with repeated insert
+ * Time Complexity: O(nk + bucketSize), divided by threads except for the grouping
+ */
+    template <typename RandomIt>
+    void bulkLoad(RandomIt first, size_t n, unsigned threads)
+    {
+        size_t bucketSize = findMinimumBucketSize((size_t)floor((double)n / maxLoadFactor) + 1);
+        allocateBuckets(bucketSize);
+        if (!std::allocator_traits<Allocator>::is_always_equal::value || n < BULK_PARALLEL_THRESHOLD || threads == 0)
+        {
+            threads = 1;
+        }
+        threads = (unsigned)std::min<size_t>(threads, occupied.size());
+        std::vector<size_t> inserted(threads, 0);
+        // link element i into its bucket, or assign its value if the key is already there
+        auto link = [&](size_t i, size_t hashValue, unsigned t) {
+            size_t position = policy.bucket(hashValue), probes = 0;
+            HashNodeList& list = buckets[position];
+            ListIterator listIt = findBefore(list, first[i].first, hashValue, probes);
+            if (listIt != list.end())
+            {
+                std::next(listIt)->node.second = first[i].second;
+                return;
+            }
+            list.emplace_front(hashValue, first[i].first, first[i].second);
+            setOccupied(occupied, position);
+            inserted[t]++;
+        };
+        if (threads == 1)
+        {
+            for (size_t i = 0; i < n; i++)
+            {
+                size_t hashValue = hash(first[i].first);
+                link(i, hashValue, 0);
+                filter.add(hashValue);
+            }
+        }
+        else
+        {
+            auto parallel = [threads](auto task) {
+                std::vector<std::thread> workers;
+                for (unsigned t = 1; t < threads; t++)
+                {
+                    workers.emplace_back(task, t);
+                }
+                task(0u);
+                for (auto& w : workers) w.join();
+            };
+            std::vector<size_t> hashValues(n);
+            parallel([&](unsigned t) {
+                for (size_t i = n * t / threads; i < n * (t + 1) / threads; i++)
+                {
+                    hashValues[i] = hash(first[i].first);
+                }
+            });
+            // thread t owns the buckets of the bitmap words [words * t / threads, words * (t + 1) / threads)
+            size_t words = occupied.size();
+            auto owner = [&](size_t i) { return (policy.bucket(hashValues[i]) >> 6) * threads / words; };
+            std::vector<size_t> offsets(threads + 1, 0);
+            for (size_t i = 0; i < n; i++)
+            {
+                offsets[owner(i) + 1]++;
+            }
+            for (unsigned t = 0; t < threads; t++)
+            {
+                offsets[t + 1] += offsets[t];
+            }
+            std::vector<size_t> order(n);
+            std::vector<size_t> next(offsets.begin(), offsets.end() - 1);
+            for (size_t i = 0; i < n; i++)
+            {
+                order[next[owner(i)]++] = i;
+            }
+            parallel([&](unsigned t) {
+                for (size_t j = offsets[t]; j < offsets[t + 1]; j++)
+                {
+                    link(order[j], hashValues[order[j]], t);
+                }
+            });
+            for (size_t hashValue : hashValues)
+            {
+                filter.add(hashValue);
+            }
+        }
+        for (size_t count : inserted)
+        {
+            tableSize += count;
+        }
+        firstBucketIt = buckets.begin() + (long)nextOccupied(occupied, 0, buckets.size());
+    }
+
+public:
+
+    /**
+ * Construct a node from args (as a HashNode), and link it into the hashtable if its key does not exist
+ * The node is constructed in a list of its own first and spliced into its bucket, so it is never copied
+ * Time Complexity: Amortized O(k)
+ * @return a pair (iterator of the key, whether insertion took place)
+ */
+    template <typename... Args>
+    std::pair<Iterator, bool> emplace(Args&&... args)
+    {
+        HashNodeList single{NodeAllocator(allocator)};
+        single.emplace_front(0, std::forward<Args>(args)...);
+        StoredNode& stored = single.front();
+        stored.hashValue = hash(stored.node.first);
+        allocateIfMoved();
+        if (isRehashing())
+        {
+            migrate(migrationStep);
+        }
+        Iterator it = findHashed(stored.node.first, stored.hashValue);
+        if (!it.endFlag)
+        {
+            return std::make_pair(it, false);
+        }
+        it.bucketIt->splice_after(it.listItBefore, single, single.before_begin());
+        return std::make_pair(finishInsert(it), true);
+    }
+
+    /**
+ * If the key does not exist, insert it with a value constructed in place from args
+ * Otherwise do nothing: key and args are not moved from
+ * Time Complexity: Amortized O(k)
+ * @return a pair (iterator of the key, whether insertion took place)
+ */
+    template <typename... Args>
+    std::pair<Iterator, bool> tryEmplace(const Key& key, Args&&... args)
+    {
+        return tryEmplaceKey(key, std::forward<Args>(args)...);
+    }
+
+    template <typename... Args>
+    std::pair<Iterator, bool> tryEmplace(Key&& key, Args&&... args)
+    {
+        return tryEmplaceKey(std::move(key), std::forward<Args>(args)...);
+    }
+
+    /**
+ * Insert <key, value>, or assign value to the existing value of key in place
+ * Time Complexity: Amortized O(k)
+ * @return a pair (iterator of the key, whether insertion took place)
+ */
+    template <typename V>
+    std::pair<Iterator, bool> insertOrAssign(const Key& key, V&& value)
+    {
+        return insertOrAssignKey(key, std::forward<V>(value));
+    }
+
+    template <typename V>
+    std::pair<Iterator, bool> insertOrAssign(Key&& key, V&& value)
+    {
+        return insertOrAssignKey(std::move(key), std::forward<V>(value));
+    }
+
     /**
  * Insert value into the hashtable according to an iterator returned by find
  * the function can be only be called if no other write actions are done to the hashtable after the find
@@ -313,25 +1281,14 @@ public:
  */
     bool insert(const Iterator& it, const Key& key, const Value& value)
     {
-        //std::cout << "inserting " << key << " endF: " << it.endFlag << ", ";
-        // FIXME: implement this function
         bool keyExists = !it.endFlag;
         if (!keyExists) {  // The key does not exist
-            it.bucketIt->insert_after(it.listItBefore, HashNode(key, value));
-            tableSize++;
-            //std::cout << "Now table size " << tableSize << std::endl;
-            //std::cout << tableSize << std::endl;
-            if ((double)tableSize >= maxLoadFactor * (double)buckets.size()){
-                rehash(buckets.size());
-            }
+            it.bucketIt->emplace_after(it.listItBefore, it.hashValue, key, value);
+            finishInsert(it);
         }
-        else {  // The key exists
-            it.bucketIt->erase_after(it.listItBefore);
-            HashNode h = HashNode(key, value);
-            it.bucketIt->insert_after(it.bucketIt->before_begin(), h);
+        else {  // The key exists, overwrite its value in place
+            std::next(it.listItBefore)->node.second = value;
         }
-        firstBucketIt = buckets.begin(); // TODO: update firstBucketIt
-        //printTable();
         return !keyExists;
     }
 
@@ -353,7 +1310,7 @@ public:
 
     /**
  * Erase the key if it exists in the hashtable, otherwise, do nothing
- * DO NOT rehash in this function
+ * DO NOT rehash in this function, unless the load factor falls below its minimum (see setMinLoadFactor)
  * firstBucketIt should be updated
  * Time Complexity: Amortized O(k)
  * @param key
@@ -361,19 +1318,19 @@ public:
  */
     bool erase(const Key& key)
     {
-        // FIXME: implement this function
         Iterator it = find(key);
         bool keyExists = !it.endFlag;
         if (keyExists) {
             erase(it);
+            shrinkIfSparse();
         }
         return keyExists;
-        // TODO: update firstBucketIt;
     }
 
     /**
  * Erase the key at the input iterator
  * If the input iterator is the end iterator, do nothing and return the input iterator directly
+ * Never shrinks the table, so that the iterator returned stays valid while erasing during a scan
  * firstBucketIt should be updated
  * Time Complexity: O(1)
  * @param it
@@ -381,21 +1338,35 @@ public:
  */
     Iterator erase(const Iterator& it)
     {
-        // FIXME: implement this function
         if (it.endFlag) {
             return it;
         }
+        // the next node in the same bucket takes the place of the erased one after listItBefore,
+        // so the same before iterator points to it (incrementing first would leave it on the erased node)
         Iterator nextIt = it;
-        ++nextIt;
         it.bucketIt->erase_after(it.listItBefore);
         tableSize--;
-        // TODO: update firstBucketIt;
+        filter.recordErase();
+        if (filter.needsRebuild() && !isRehashing())
+        {
+            rebuildFilter();
+        }
+        if (it.bucketIt->empty())
+        {
+            clearOccupied(it.inOld ? oldOccupied : occupied, (size_t)(it.bucketIt - it.data().begin()));
+        }
+        if (std::next(it.listItBefore) == it.bucketIt->end())
+        {
+            ++nextIt.bucketIt;
+            nextIt.settle();
+        }
         return nextIt;
     }
 
     /**
  * Get the reference of value by key in the hashtable
  * If the key doesn't exist, create it first (use default constructor of Value)
+ * The key is only probed once, the value is constructed in place
  * firstBucketIt should be updated
  * If load factor exceeds maximum value, rehash the hashtable
  * Time Complexity: Amortized O(k)
@@ -404,16 +1375,12 @@ public:
  */
     Value& operator[](const Key& key)
     {
-        // FIXME: implement this function
-        Iterator it = find(key);
-        //std::cout << "Found " << key << " with endFlag " << it.endFlag << std::endl;
-        if (it.endFlag) { // Key does not exist, create it
-            Value v = Value();
-            insert(it, key, v);
-            it = find(key);
-        }
-        // Key exists
-        return (++(it.listItBefore))->second;
+        return tryEmplaceKey(key).first->second;
+    }
+
+    Value& operator[](Key&& key)
+    {
+        return tryEmplaceKey(std::move(key)).first->second;
     }
 
     /**
@@ -427,39 +1394,98 @@ public:
  */
     void rehash(size_t bucketSize)
     {
-        // FIXME: implement this function
         size_t newBucketSize = findMinimumBucketSize(bucketSize);
+        finishMigration();
         if (newBucketSize == buckets.size()) return;
-        std::vector<HashNode> tempNodes;
-        //size_t tableSizeTemp = tableSize;
-        for (VectorIterator bucketIt=firstBucketIt; bucketIt!=buckets.end();bucketIt++){
-            for (ListIterator listIt=bucketIt->begin();listIt!=bucketIt->end();listIt++) {
-                tempNodes.push_back(*listIt);
-            }
+        startResize(newBucketSize);
+        finishMigration();
+    }
+
+    /**
+ * Make room for n elements, so that they can be inserted without any rehash
+ * Do nothing if there is enough room already
+ * Time Complexity: O(nk) if the table is rehashed, O(1) otherwise
+ * @param n number of elements
+ */
+    void reserve(size_t n)
+    {
+        size_t bucketSize = (size_t)floor((double)n / maxLoadFactor) + 1;
+        if (bucketSize > buckets.size())
+        {
+            rehash(bucketSize);
         }
-        buckets = HashTableData();
-        buckets.resize(newBucketSize);
+    }
+
+    /**
+ * Rehash to the fewest buckets holding the elements below the maximum load factor
+ * Time Complexity: O(nk + bucketSize)
+ */
+    void shrinkToFit()
+    {
+        rehash(0);
+    }
+
+    /**
+     * Erase every element, the number of buckets is kept
+     * With a pooled allocator, the node memory is released in bulk afterwards
+     * Time Complexity: O(n + bucketSize)
+     */
+    void clear()
+    {
+        for (auto& list : buckets)
+        {
+            list.clear();
+        }
+        HashTableData().swap(oldBuckets);
+        std::fill(occupied.begin(), occupied.end(), 0);
+        OccupancyBitmap().swap(oldOccupied);
+        migrateIndex = 0;
         tableSize = 0;
-        for (auto &node: tempNodes){
-            insert(node.first,node.second);
+        filter.clear();
+        firstBucketIt = buckets.end();
+        releaseNodes(allocator, 0);
+    }
+
+    /**
+     * Enable or disable incremental resizing
+     * When enabled, a resize keeps the old buckets alongside the new ones and every
+     * insert / find / erase relinks up to step old buckets, so no single operation
+     * pays for moving the whole table. Lookups check both arrays until it finishes.
+     * Disabling it finishes any resize in progress
+     * @param enabled
+     * @param step number of old buckets migrated per operation
+     */
+    void setIncrementalRehash(bool enabled, size_t step = DEFAULT_MIGRATION_STEP)
+    {
+        incrementalRehash = enabled;
+        migrationStep = step > 0 ? step : 1;
+        if (!enabled)
+        {
+            finishMigration();
         }
-        //tableSize = tableSizeTemp; // insert() will add tableSize, but here we just re-insert the nodes, no increase.
     }
 
+    /**
+     * @return whether an incremental resize is in progress
+     */
+    bool isRehashing() const { return !oldBuckets.empty(); }
+
+    Allocator getAllocator() const { return allocator; }
+
     /**
  * @return the number of elements in the hashtable
  */
     size_t size() const { return tableSize; }
 
     /**
- * @return the number of buckets in the hashtable
+ * @return the number of buckets in the hashtable, 0 after the table is moved from until it is used again
  */
     size_t bucketSize() const { return buckets.size(); }
 
     /**
  * @return the current load factor of the hashtable
  */
-    double loadFactor() const { return (double)tableSize / (double)buckets.size(); }
+    double loadFactor() const { return buckets.empty() ? 0 : (double)tableSize / (double)buckets.size(); }
 
     /**
  * @return the maximum load factor of the hashtable
@@ -468,26 +1494,147 @@ public:
 
     /**
  * Set the max load factor
- * @throw std::range_error if the load factor is too small
+ * @throw std::range_error if the load factor is too small, or below 4 times the minimum load factor
  * @param loadFactor
  */
     void setMaxLoadFactor(double loadFactor)
     {
-        if (loadFactor <= 1e-9)
+        if (loadFactor <= 1e-9 || minLoadFactor > loadFactor / 4)
         {
             throw std::range_error("invalid load factor!");
         }
         maxLoadFactor = loadFactor;
         rehash(buckets.size());
+        rebuildFilter();
     }
 
-    void printTable(){
-        for (VectorIterator bucketIt=firstBucketIt; bucketIt!=buckets.end(); bucketIt++){
-            if (bucketIt->begin()!=bucketIt->end()){
-                for (ListIterator listIt=bucketIt->begin(); listIt!=bucketIt->end(); listIt++){
-                    std::cout << listIt->first << ": " << listIt->second << "\n";
+    /**
+ * Set the minimum load factor: when an erase by key leaves the load factor below it, the table shrinks
+ * to about half the maximum load factor, 0 (the default) never shrinks
+ * It must be at most a quarter of the maximum load factor, so that a table just grown or shrunk
+ * (at about half the maximum) is at least twice the minimum, and resizes cannot follow each other
+ * @throw std::range_error if the load factor is negative or above a quarter of the maximum
+ * @param loadFactor
+ */
+    void setMinLoadFactor(double loadFactor)
+    {
+        if (loadFactor < 0 || loadFactor > maxLoadFactor / 4)
+        {
+            throw std::range_error("invalid load factor!");
+        }
+        minLoadFactor = loadFactor;
+    }
+
+    /**
+ * @return the minimum load factor of the hashtable
+ */
+    double getMinLoadFactor() const { return minLoadFactor; }
+
+    /**
+ * Set the false positive target of the filter and rebuild it, see BlockedBloomFilter
+ * Nothing happens unless Filter = BlockedBloomFilter
+ * Time Complexity: O(n + bucketSize / 64)
+ * @throw std::range_error if the rate is not in (0, 1)
+ * @param rate
+ */
+    void setFilterFalsePositiveRate(double rate)
+    {
+        filter.setFalsePositiveRate(rate);
+        finishMigration();
+        rebuildFilter();
+    }
+
+    /**
+ * @return the lookups answered by the filter, all 0 unless Filter = BlockedBloomFilter
+ */
+    HashTableFilterStats getFilterStats() const { return filter.getStats(); }
+
+    void resetFilterStats() { filter.resetStats(); }
+
+    /**
+ * Call f(node) on every node of the hashtable, for bulk scans
+ * The buckets are split into ranges scanned by different threads, so f runs concurrently
+ * and must not modify the hashtable; the order of the nodes is unspecified
+ * Time Complexity: O(n + bucketSize / 64), divided by threads
+ * @param f called with a HashNode&
+ * @param threads number of threads
+ */
+    template <typename F>
+    void forEach(F f, unsigned threads = std::thread::hardware_concurrency())
+    {
+        forEachIn(buckets, occupied, 0, f, threads);
+        if (isRehashing())
+        {
+            forEachIn(oldBuckets, oldOccupied, migrateIndex, f, threads);
+        }
+    }
+
+    /**
+ * Collect the statistics of the hashtable
+ * The chain lengths and memory are computed here, the lookup and rehash counters
+ * are only recorded when Stats = HashTableStats, at no cost otherwise
+ * Time Complexity: O(n + bucketSize)
+ * @return the statistics, see HashTableStatsReport::toJson for a JSON dump
+ */
+    HashTableStatsReport getStats() const
+    {
+        HashTableStatsReport report;
+        report.size = tableSize;
+        report.bucketSize = buckets.size();
+        report.loadFactor = loadFactor();
+        report.maxLoadFactor = maxLoadFactor;
+        size_t hotLength = (size_t)(2 * std::max(1.0, report.loadFactor));
+        size_t hotBuckets = 0, totalBuckets = 0;
+        auto count = [&](const HashTableData& data, size_t first)
+        {
+            for (size_t i = first; i < data.size(); i++)
+            {
+                size_t length = (size_t)std::distance(data[i].begin(), data[i].end());
+                if (length >= report.chainLengthHistogram.size())
+                {
+                    report.chainLengthHistogram.resize(length + 1, 0);
                 }
+                report.chainLengthHistogram[length]++;
+                hotBuckets += length > hotLength;
+                totalBuckets++;
             }
+        };
+        count(buckets, 0);
+        count(oldBuckets, migrateIndex);
+        report.maxChainLength = report.chainLengthHistogram.empty() ? 0 : report.chainLengthHistogram.size() - 1;
+        report.hotBucketFraction = totalBuckets == 0 ? 0 : (double)hotBuckets / (double)totalBuckets;
+        HashTableMemoryUsage memory = memoryUsage();
+        report.bytesAllocated = memory.total();
+        report.filterBytes = memory.filterBytes;
+        report.addRecorded(stats);
+        return report;
+    }
+
+    /**
+ * The memory held by the hashtable, by part, see HashTableMemoryUsage
+ * Time Complexity: O(1)
+ */
+    HashTableMemoryUsage memoryUsage() const
+    {
+        HashTableMemoryUsage memory;
+        memory.bucketBytes = (buckets.capacity() + oldBuckets.capacity()) * sizeof(HashNodeList);
+        memory.bitmapBytes = (occupied.capacity() + oldOccupied.capacity()) * sizeof(uint64_t);
+        // a forward_list node is the next pointer followed by the element
+        memory.nodeBytes = tableSize * (sizeof(void*) + sizeof(StoredNode));
+        memory.filterBytes = filter.bytes();
+        return memory;
+    }
+
+    /**
+ * Reset the lookup and rehash counters
+ */
+    void resetStats() { stats.reset(); }
+
+    void printTable(){
+        for (Iterator it = begin(); it != end(); ++it){
+            std::cout << it->first << ": " << it->second << "\n";
         }
     }
 };
+
+#endif //VE281P2_HASHTABLE_HPP
@@ -0,0 +1,266 @@
+#ifndef VE281P2_HASHTABLE_FILTER_HPP
+#define VE281P2_HASHTABLE_FILTER_HPP
+#include "hash_functions.hpp"
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+/**
+ * Counters of the lookups probing a filter, returned by HashTable::getFilterStats
+ */
+struct HashTableFilterStats
+{
+    uint64_t queries = 0;        // lookups that probed the filter
+    uint64_t negatives = 0;      // lookups answered by the filter alone
+    uint64_t falsePositives = 0; // lookups that passed the filter but found no key
+
+    /**
+     * @return the fraction of absent keys the filter let through
+     */
+    double observedFalsePositiveRate() const
+    {
+        uint64_t absent = negatives + falsePositives;
+        return absent == 0 ? 0 : (double)falsePositives / (double)absent;
+    }
+};
+
+/**
+ * Membership filters for the Filter parameter of HashTable, probed by hash value before the buckets
+ * NoHashTableFilter keeps nothing and every call to it compiles away (the default)
+ * BlockedBloomFilter answers most lookups of absent keys without touching a bucket
+ */
+struct NoHashTableFilter
+{
+    static constexpr bool enabled = false;
+
+    void reset(size_t) {}
+    void clear() {}
+    void add(size_t) {}
+    bool mayContain(size_t) const { return true; }
+    void recordQuery(bool) {}
+    void recordFalsePositive() {}
+    void recordErase() {}
+    bool needsRebuild() const { return false; }
+    void setFalsePositiveRate(double) {}
+    HashTableFilterStats getStats() const { return HashTableFilterStats(); }
+    void resetStats() {}
+    size_t bytes() const { return 0; }
+};
+
+/**
+ * A split block Bloom filter: a key sets one bit in each of the 8 words of one 64-byte block,
+ * so a probe reads a single cache line, and with AVX2 builds the 8 bit masks and tests them in a few instructions
+ * The number of blocks is chosen for the expected number of keys and the false positive target
+ * Bits cannot be cleared, so erased keys are only counted, and the owner rebuilds the filter
+ * from the cached hash values when they reach half of the keys added (needsRebuild)
+ */
+class BlockedBloomFilter
+{
+public:
+    static constexpr bool enabled = true;
+    static constexpr double DEFAULT_FALSE_POSITIVE_RATE = 0.01;
+
+protected:
+    static constexpr size_t WORDS = 8;
+    static constexpr unsigned BIT_SHIFT = 26; // the top 6 bits of a 32-bit product select a bit of a word
+    // odd multipliers giving the bit of each word (those of the Parquet split block filter)
+    static constexpr uint32_t SALT[WORDS] = {
+        0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU, 0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U
+    };
+
+    struct alignas(64) Block
+    {
+        uint64_t words[WORDS];
+    };
+
+    std::vector<Block> blocks;
+    double falsePositiveRate = DEFAULT_FALSE_POSITIVE_RATE;
+    double keysPerBlock = keysPerBlockFor(DEFAULT_FALSE_POSITIVE_RATE);
+    size_t addedKeys = 0;  // keys added since the last reset
+    size_t erasedKeys = 0; // keys erased from the owner since the last reset
+    HashTableFilterStats stats;
+
+    /**
+     * Expected false positive rate with an average of load keys per block,
+     * the number of keys in a block being Poisson distributed
+     */
+    static double expectedFalsePositiveRate(double load)
+    {
+        double poisson = std::exp(-load), rate = 0;
+        for (size_t j = 0; j < (size_t)(load + 12 * std::sqrt(load) + 16); j++)
+        {
+            if (j > 0) poisson *= load / (double)j;
+            rate += poisson * std::pow(1 - std::pow(1 - 1.0 / 64, (double)j), (double)WORDS);
+        }
+        return rate;
+    }
+
+    /**
+     * The largest average number of keys per block meeting the false positive target, by bisection
+     */
+    static double keysPerBlockFor(double rate)
+    {
+        double low = 0, high = 512;
+        for (int i = 0; i < 50; i++)
+        {
+            double middle = (low + high) / 2;
+            (expectedFalsePositiveRate(middle) <= rate ? low : high) = middle;
+        }
+        return std::max(low, 0.01);
+    }
+
+    size_t blockIndex(uint64_t mixed) const
+    {
+        return (size_t)(((mixed >> 32) * (uint64_t)blocks.size()) >> 32);
+    }
+
+#ifdef __AVX2__
+    /**
+     * The bit of each word, as masks of words 0-3 (low) and 4-7 (high)
+     */
+    static void masks(uint64_t mixed, __m256i& low, __m256i& high)
+    {
+        __m256i x = _mm256_set1_epi32((int)(uint32_t)mixed);
+        __m256i salt = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(SALT));
+        __m256i shifts = _mm256_srli_epi32(_mm256_mullo_epi32(x, salt), BIT_SHIFT);
+        __m256i one = _mm256_set1_epi64x(1);
+        low = _mm256_sllv_epi64(one, _mm256_cvtepu32_epi64(_mm256_castsi256_si128(shifts)));
+        high = _mm256_sllv_epi64(one, _mm256_cvtepu32_epi64(_mm256_extracti128_si256(shifts, 1)));
+    }
+#else
+    static uint64_t mask(uint64_t mixed, size_t word)
+    {
+        return (uint64_t)1 << (((uint32_t)mixed * SALT[word]) >> BIT_SHIFT);
+    }
+#endif
+
+public:
+    BlockedBloomFilter()
+    {
+        reset(0);
+    }
+
+    /**
+     * Empty the filter and size it for expectedKeys keys
+     * Time Complexity: O(expectedKeys)
+     */
+    void reset(size_t expectedKeys)
+    {
+        size_t count = std::max<size_t>(1, (size_t)std::ceil((double)expectedKeys / keysPerBlock));
+        // the block is taken from the high 32 bits of the hash
+        count = std::min<size_t>(count, (size_t)1 << 32);
+        // a new vector, so that shrinking returns the memory
+        std::vector<Block>(count).swap(blocks);
+        addedKeys = 0;
+        erasedKeys = 0;
+    }
+
+    /**
+     * Empty the filter, keeping its size
+     */
+    void clear()
+    {
+        blocks.assign(blocks.size(), Block());
+        addedKeys = 0;
+        erasedKeys = 0;
+    }
+
+    /**
+     * The hash of HashTable may be the identity (std::hash of integers), so it is mixed first:
+     * the high half selects the block and the low half the bits
+     * Time Complexity: O(1), one cache line
+     */
+    void add(size_t hashValue)
+    {
+        uint64_t mixed = HashFunctions::mix64((uint64_t)hashValue);
+        uint64_t* words = blocks[blockIndex(mixed)].words;
+#ifdef __AVX2__
+        __m256i low, high;
+        masks(mixed, low, high);
+        __m256i* block = reinterpret_cast<__m256i*>(words);
+        _mm256_store_si256(block, _mm256_or_si256(_mm256_load_si256(block), low));
+        _mm256_store_si256(block + 1, _mm256_or_si256(_mm256_load_si256(block + 1), high));
+#else
+        for (size_t i = 0; i < WORDS; i++)
+        {
+            words[i] |= mask(mixed, i);
+        }
+#endif
+        addedKeys++;
+    }
+
+    /**
+     * Time Complexity: O(1), one cache line
+     * @return false if no key of this hash value was added since the last reset
+     */
+    bool mayContain(size_t hashValue) const
+    {
+        uint64_t mixed = HashFunctions::mix64((uint64_t)hashValue);
+        const uint64_t* words = blocks[blockIndex(mixed)].words;
+#ifdef __AVX2__
+        __m256i low, high;
+        masks(mixed, low, high);
+        const __m256i* block = reinterpret_cast<const __m256i*>(words);
+        // testc is 1 when every bit of the mask is set in the block
+        return _mm256_testc_si256(_mm256_load_si256(block), low) & _mm256_testc_si256(_mm256_load_si256(block + 1), high);
+#else
+        uint64_t missing = 0;
+        for (size_t i = 0; i < WORDS; i++)
+        {
+            missing |= ~words[i] & mask(mixed, i);
+        }
+        return missing == 0;
+#endif
+    }
+
+    /**
+     * @param passed whether mayContain returned true
+     */
+    void recordQuery(bool passed)
+    {
+        stats.queries++;
+        stats.negatives += !passed;
+    }
+
+    void recordFalsePositive() { stats.falsePositives++; }
+
+    void recordErase() { erasedKeys++; }
+
+    /**
+     * @return whether the erased keys still set in the filter are half of the keys added,
+     * which raises the false positive rate, so the owner should rebuild the filter
+     */
+    bool needsRebuild() const
+    {
+        return erasedKeys * 2 > addedKeys && erasedKeys > WORDS;
+    }
+
+    /**
+     * Set the false positive target, applied from the next reset
+     * @throw std::range_error if the rate is not in (0, 1)
+     * @param rate
+     */
+    void setFalsePositiveRate(double rate)
+    {
+        if (!(rate > 0 && rate < 1))
+        {
+            throw std::range_error("invalid false positive rate!");
+        }
+        falsePositiveRate = rate;
+        keysPerBlock = keysPerBlockFor(rate);
+    }
+
+    double getFalsePositiveRate() const { return falsePositiveRate; }
+
+    HashTableFilterStats getStats() const { return stats; }
+
+    void resetStats() { stats = HashTableFilterStats(); }
+
+    size_t bytes() const { return blocks.capacity() * sizeof(Block); }
+};
+
+#endif //VE281P2_HASHTABLE_FILTER_HPP
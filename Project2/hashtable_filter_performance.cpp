@@ -0,0 +1,108 @@
+#include "hashtable.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+using namespace std;
+
+// Usage: ./hashtable_filter_performance [max_exponent=6] [seed]
+// Build with -mavx2 to probe the filter with AVX2
+// For n from 10^5 to 10^max_exponent int64 keys (or 40-char strings), n contains are run of which 90% miss,
+// at maximum load factors 0.5 (the default) and 2, on HashTable without a filter and with a BlockedBloomFilter
+// Output (CSV): key_type,filter,false_positive_target,n,max_load_factor,contains,observed_false_positive_rate,filter_bytes_per_key
+// (nanoseconds per contains)
+
+template <typename Key>
+using filtered_table = HashTable<Key, long, hash<Key>, equal_to<Key>, PrimeBucketPolicy,
+                                 allocator<pair<const Key, long>>, NoHashTableStats, BlockedBloomFilter>;
+
+uint64_t mix(uint64_t x)
+{
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+long make_int64(uint64_t id) { return (long)mix(id); }
+
+string make_long_string(uint64_t id)
+{
+    string s = "user:" + to_string(mix(id)) + ":" + to_string(id);
+    s.resize(40, '.');
+    return s;
+}
+
+template <typename Table, typename Key>
+void run(const char *key_type, const char *filter, double target, double load_factor,
+         const vector<Key> &keys, const vector<Key> &queries)
+{
+    Table table;
+    table.setMaxLoadFactor(load_factor);
+    if (target > 0) table.setFilterFalsePositiveRate(target);
+    for (size_t i = 0; i < keys.size(); i++)
+    {
+        table.insert(keys[i], (long)i);
+    }
+    table.resetFilterStats();
+    size_t found = 0;
+    auto start = chrono::steady_clock::now();
+    for (auto &k : queries)
+    {
+        found += table.contains(k);
+    }
+    chrono::duration<double, nano> elapsed = chrono::steady_clock::now() - start;
+    if (found != queries.size() / 10)
+    {
+        fprintf(stderr, "%s %s: %zu keys found instead of %zu\n", key_type, filter, found, queries.size() / 10);
+        exit(1);
+    }
+    HashTableFilterStats stats = table.getFilterStats();
+    size_t filter_bytes = table.getStats().filterBytes;
+    printf("%s,%s,%g,%zu,%g,%.2f,%.5f,%.2f\n", key_type, filter, target, keys.size(), load_factor,
+           elapsed.count() / (double)queries.size(), stats.observedFalsePositiveRate(),
+           (double)filter_bytes / (double)keys.size());
+    fflush(stdout);
+}
+
+template <typename Key>
+void run_all(const char *key_type, size_t n, unsigned long seed, Key (*make)(uint64_t))
+{
+    mt19937_64 gen(seed);
+    vector<Key> keys, queries;
+    keys.reserve(n);
+    queries.reserve(n);
+    for (size_t i = 0; i < n; i++)
+    {
+        keys.push_back(make(i));
+        // every tenth query is a key, the others were never inserted
+        queries.push_back(i % 10 == 0 ? make(gen() % n) : make(n + i));
+    }
+    shuffle(queries.begin(), queries.end(), gen);
+    for (double load_factor : {0.5, 2.0})
+    {
+        run<HashTable<Key, long>>(key_type, "none", 0, load_factor, keys, queries);
+        for (double target : {0.1, 0.01, 0.001})
+        {
+            run<filtered_table<Key>>(key_type, "blocked_bloom", target, load_factor, keys, queries);
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int max_exponent = argc > 1 ? atoi(argv[1]) : 6;
+    unsigned long seed = argc > 2 ? strtoul(argv[2], nullptr, 10) : 281;
+    printf("key_type,filter,false_positive_target,n,max_load_factor,contains,observed_false_positive_rate,filter_bytes_per_key\n");
+    for (int e = 5; e <= max_exponent; e++)
+    {
+        size_t n = (size_t)pow(10, e);
+        run_all<long>("int64", n, seed, make_int64);
+        run_all<string>("long_string", n, seed, make_long_string);
+    }
+    return 0;
+}
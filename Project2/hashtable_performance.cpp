@@ -0,0 +1,324 @@
+#include "flat_hashtable.hpp"
+#include "hashtable.hpp"
+#include <malloc.h>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+using namespace std;
+
+// Usage: ./hashtable_performance [max_exponent=6] [seed]
+// Sizes run from 10^3 to 10^max_exponent (10^8 needs tens of GB with string keys),
+// for int64, short string (12 chars, inline in std::string) and long string (40 chars) keys,
+// at maximum load factors 0.5 and 0.875
+// Workloads, in this order on one table:
+//   insert     n new keys
+//   find_hit   the n keys, in random order
+//   find_miss  n keys never inserted
+//   find_zipf  n finds of inserted keys, Zipf distributed (theta = 0.99, hottest keys first inserted)
+//   mixed      n operations: 80% Zipf finds, 10% inserts of new keys, 10% erases of those keys
+//   erase      the n keys
+// Output (CSV): table,key_type,n,max_load_factor,insert,find_hit,find_miss,find_zipf,mixed,erase,bytes_per_entry
+// (nanoseconds per operation; bytes_per_entry is heap usage after the inserts, divided by n)
+
+// Heap bytes in use, counted by replacing the global operator new and delete
+static size_t live_bytes = 0;
+
+void *operator new(size_t size)
+{
+    void *p = malloc(size == 0 ? 1 : size);
+    if (p == nullptr) throw bad_alloc();
+    live_bytes += malloc_usable_size(p);
+    return p;
+}
+
+void operator delete(void *p) noexcept
+{
+    if (p == nullptr) return;
+    live_bytes -= malloc_usable_size(p);
+    free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    operator delete(p);
+}
+
+// FlatHashTable allocates its control bytes with the aligned overloads, which do not go through the ones above
+void *operator new(size_t size, align_val_t alignment)
+{
+    size_t align = (size_t)alignment;
+    // aligned_alloc wants a multiple of the alignment
+    void *p = aligned_alloc(align, (max<size_t>(size, 1) + align - 1) / align * align);
+    if (p == nullptr) throw bad_alloc();
+    live_bytes += malloc_usable_size(p);
+    return p;
+}
+
+void operator delete(void *p, align_val_t) noexcept
+{
+    operator delete(p);
+}
+
+void operator delete(void *p, size_t, align_val_t) noexcept
+{
+    operator delete(p);
+}
+
+// splitmix64 finalizer, a bijection so distinct ids give distinct keys
+uint64_t mix(uint64_t x)
+{
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+// length - 6 pseudo random characters, then id in base 62 (unique below 62^6)
+string make_string(uint64_t id, size_t length)
+{
+    static const char digits[] = "0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
+    string s(length, ' ');
+    uint64_t noise = mix(id);
+    for (size_t i = 0; i + 6 < length; i++)
+    {
+        if (i % 10 == 0) noise = mix(noise);
+        s[i] = digits[noise % 62];
+        noise /= 62;
+    }
+    for (size_t i = length; i-- > length - 6;)
+    {
+        s[i] = digits[id % 62];
+        id /= 62;
+    }
+    return s;
+}
+
+long make_int64(uint64_t id) { return (long)mix(id); }
+
+string make_short_string(uint64_t id) { return make_string(id, 12); }
+
+string make_long_string(uint64_t id) { return make_string(id, 40); }
+
+/**
+ * Zipf distributed ranks in [0, n), as in YCSB (Gray et al., Quickly generating billion-record synthetic databases)
+ */
+class zipf_generator
+{
+private:
+    size_t n;
+    double theta, alpha, zetan, eta;
+
+public:
+    zipf_generator(size_t n, double theta) : n(n), theta(theta)
+    {
+        double zeta2 = 1 + pow(0.5, theta);
+        zetan = 0;
+        for (size_t i = 1; i <= n; i++)
+        {
+            zetan += 1 / pow((double)i, theta);
+        }
+        alpha = 1 / (1 - theta);
+        eta = (1 - pow(2.0 / (double)n, 1 - theta)) / (1 - zeta2 / zetan);
+    }
+
+    size_t operator()(mt19937_64 &gen)
+    {
+        double u = uniform_real_distribution<double>(0, 1)(gen);
+        double uz = u * zetan;
+        if (uz < 1) return 0;
+        if (uz < 1 + pow(0.5, theta)) return 1;
+        return min(n - 1, (size_t)((double)n * pow(eta * u - eta + 1, alpha)));
+    }
+};
+
+/**
+ * The operations of the benchmark on each table
+ */
+template <typename Key>
+struct hashtable_adapter
+{
+    HashTable<Key, long> table;
+    void set_max_load_factor(double f) { table.setMaxLoadFactor(f); }
+    void insert(const Key &k, long v) { table.insert(k, v); }
+    bool find(const Key &k) { return table.find(k) != table.end(); }
+    bool erase(const Key &k) { return table.erase(k); }
+    size_t size() { return table.size(); }
+};
+
+template <typename Key>
+struct flat_hashtable_adapter
+{
+    FlatHashTable<Key, long> table;
+    void set_max_load_factor(double f) { table.setMaxLoadFactor(f); }
+    void insert(const Key &k, long v) { table.insert(k, v); }
+    bool find(const Key &k) { return table.find(k) != table.end(); }
+    bool erase(const Key &k) { return table.erase(k); }
+    size_t size() { return table.size(); }
+};
+
+template <typename Key>
+struct unordered_map_adapter
+{
+    unordered_map<Key, long> table;
+    void set_max_load_factor(double f) { table.max_load_factor((float)f); }
+    void insert(const Key &k, long v) { table.insert_or_assign(k, v); }
+    bool find(const Key &k) { return table.find(k) != table.end(); }
+    bool erase(const Key &k) { return table.erase(k) != 0; }
+    size_t size() { return table.size(); }
+};
+
+template <typename Key>
+struct workload
+{
+    vector<Key> keys;           // inserted
+    vector<Key> hit_order;      // keys, shuffled
+    vector<Key> misses;         // never inserted before mixed
+    vector<size_t> zipf;        // indices into keys
+    vector<unsigned char> ops;  // mixed: 0 find, 1 insert, 2 erase
+};
+
+double ns_per_op(chrono::steady_clock::time_point &start, size_t ops)
+{
+    auto now = chrono::steady_clock::now();
+    chrono::duration<double, nano> elapsed = now - start;
+    start = now;
+    return elapsed.count() / (double)ops;
+}
+
+void check(const char *table, const char *phase, size_t got, size_t expected)
+{
+    if (got != expected)
+    {
+        fprintf(stderr, "%s %s: %zu instead of %zu\n", table, phase, got, expected);
+        exit(1);
+    }
+}
+
+template <typename Adapter, typename Key>
+void run(const char *table_name, const char *key_type, double load_factor, const workload<Key> &w)
+{
+    size_t n = w.keys.size();
+    size_t bytes_before = live_bytes;
+    Adapter table;
+    table.set_max_load_factor(load_factor);
+    auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i < n; i++)
+    {
+        table.insert(w.keys[i], (long)i);
+    }
+    double insert_time = ns_per_op(start, n);
+    double bytes_per_entry = (double)(live_bytes - bytes_before) / (double)n;
+    check(table_name, "insert", table.size(), n);
+    start = chrono::steady_clock::now();
+
+    size_t found = 0;
+    for (auto &k : w.hit_order)
+    {
+        found += table.find(k);
+    }
+    double hit_time = ns_per_op(start, n);
+    check(table_name, "find_hit", found, n);
+
+    found = 0;
+    for (auto &k : w.misses)
+    {
+        found += table.find(k);
+    }
+    double miss_time = ns_per_op(start, n);
+    check(table_name, "find_miss", found, 0);
+
+    found = 0;
+    for (auto i : w.zipf)
+    {
+        found += table.find(w.keys[i]);
+    }
+    double zipf_time = ns_per_op(start, n);
+    check(table_name, "find_zipf", found, n);
+
+    size_t inserted = 0, erased = 0, z = 0;
+    for (auto op : w.ops)
+    {
+        if (op == 1)
+        {
+            table.insert(w.misses[inserted++], 0);
+        }
+        else if (op == 2 && erased < inserted)
+        {
+            table.erase(w.misses[erased++]);
+        }
+        else
+        {
+            found += table.find(w.keys[w.zipf[z++]]);
+        }
+    }
+    double mixed_time = ns_per_op(start, n);
+    check(table_name, "mixed", table.size(), n + inserted - erased);
+
+    found = 0;
+    for (auto &k : w.keys)
+    {
+        found += table.erase(k);
+    }
+    double erase_time = ns_per_op(start, n);
+    check(table_name, "erase", found, n);
+
+    printf("%s,%s,%zu,%.3f,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f,%.1f\n", table_name, key_type, n, load_factor,
+           insert_time, hit_time, miss_time, zipf_time, mixed_time, erase_time, bytes_per_entry);
+    fflush(stdout);
+}
+
+template <typename Key>
+void run_all(const char *key_type, size_t n, unsigned long seed, Key (*make)(uint64_t))
+{
+    mt19937_64 gen(seed);
+    workload<Key> w;
+    w.keys.reserve(n);
+    w.misses.reserve(n);
+    for (size_t i = 0; i < n; i++)
+    {
+        w.keys.push_back(make(i));
+        w.misses.push_back(make(n + i));
+    }
+    w.hit_order = w.keys;
+    shuffle(w.hit_order.begin(), w.hit_order.end(), gen);
+    zipf_generator zipf(n, 0.99);
+    w.zipf.resize(n);
+    for (auto &i : w.zipf)
+    {
+        i = zipf(gen);
+    }
+    uniform_int_distribution<int> percent(0, 99);
+    w.ops.resize(n);
+    for (auto &op : w.ops)
+    {
+        int p = percent(gen);
+        op = p < 80 ? 0 : p < 90 ? 1 : 2;
+    }
+    for (double load_factor : {0.5, 0.875})
+    {
+        run<hashtable_adapter<Key>>("HashTable", key_type, load_factor, w);
+        run<flat_hashtable_adapter<Key>>("FlatHashTable", key_type, load_factor, w);
+        run<unordered_map_adapter<Key>>("unordered_map", key_type, load_factor, w);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int max_exponent = argc > 1 ? atoi(argv[1]) : 6;
+    unsigned long seed = argc > 2 ? strtoul(argv[2], nullptr, 10) : 281;
+    printf("table,key_type,n,max_load_factor,insert,find_hit,find_miss,find_zipf,mixed,erase,bytes_per_entry\n");
+    for (int e = 3; e <= max_exponent; e++)
+    {
+        size_t n = (size_t)pow(10, e);
+        run_all<long>("int64", n, seed, make_int64);
+        run_all<string>("short_string", n, seed, make_short_string);
+        run_all<string>("long_string", n, seed, make_long_string);
+    }
+    return 0;
+}
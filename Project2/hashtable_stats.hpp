@@ -0,0 +1,169 @@
+#ifndef VE281P2_HASHTABLE_STATS_HPP
+#define VE281P2_HASHTABLE_STATS_HPP
+#include <algorithm>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/**
+ * Statistics recorders for the Stats parameter of HashTable
+ * NoHashTableStats records nothing and every call to it compiles away (the default)
+ * HashTableStats counts the probes of every lookup (including the one done by each insertion)
+ * and the number and time of rehashes
+ * The chain lengths and memory are computed on demand by HashTable::getStats with either recorder
+ */
+struct NoHashTableStats
+{
+    static constexpr bool enabled = false;
+
+    void recordLookup(bool, size_t) {}
+    void recordRehash(double) {}
+    void recordRehashTime(double) {}
+    void reset() {}
+};
+
+struct HashTableStats
+{
+    static constexpr bool enabled = true;
+
+    uint64_t successfulLookups = 0;
+    uint64_t successfulProbes = 0;    // nodes compared by successful lookups
+    uint64_t maxSuccessfulProbes = 0;
+    uint64_t failedLookups = 0;
+    uint64_t failedProbes = 0;        // nodes compared by failed lookups
+    uint64_t maxFailedProbes = 0;
+    uint64_t rehashCount = 0;         // resizes started
+    double rehashSeconds = 0;         // wall time spent starting and migrating resizes
+
+    /**
+     * @param found whether the key was found
+     * @param probes number of nodes compared with the key
+     */
+    void recordLookup(bool found, size_t probes)
+    {
+        if (found)
+        {
+            successfulLookups++;
+            successfulProbes += probes;
+            maxSuccessfulProbes = std::max<uint64_t>(maxSuccessfulProbes, probes);
+        }
+        else
+        {
+            failedLookups++;
+            failedProbes += probes;
+            maxFailedProbes = std::max<uint64_t>(maxFailedProbes, probes);
+        }
+    }
+
+    void recordRehash(double seconds)
+    {
+        rehashCount++;
+        rehashSeconds += seconds;
+    }
+
+    /**
+     * Time of a migration step of an incremental resize, the resize itself is already counted
+     */
+    void recordRehashTime(double seconds)
+    {
+        rehashSeconds += seconds;
+    }
+
+    void reset()
+    {
+        *this = HashTableStats();
+    }
+};
+
+/**
+ * The bytes held by a HashTable, returned by HashTable::memoryUsage
+ * Nodes are counted at their size, without the overhead of the allocator (glibc malloc adds 8 bytes
+ * and rounds up to 16, a PoolAllocator adds nothing but keeps the slots of erased nodes)
+ */
+struct HashTableMemoryUsage
+{
+    size_t bucketBytes = 0; // the bucket arrays, an empty list head per bucket
+    size_t bitmapBytes = 0; // the occupancy bitmaps
+    size_t nodeBytes = 0;   // the nodes
+    size_t filterBytes = 0; // the filter, 0 without one
+
+    size_t total() const { return bucketBytes + bitmapBytes + nodeBytes + filterBytes; }
+};
+
+/**
+ * A snapshot of the statistics of a HashTable, returned by HashTable::getStats
+ * The lookup and rehash fields are 0 unless the table records them (Stats = HashTableStats)
+ */
+struct HashTableStatsReport
+{
+    size_t size = 0;
+    size_t bucketSize = 0;
+    double loadFactor = 0;
+    double maxLoadFactor = 0;
+    std::vector<size_t> chainLengthHistogram; // [i] is the number of buckets holding i nodes
+    size_t maxChainLength = 0;
+    double hotBucketFraction = 0;             // fraction of buckets longer than twice max(1, load factor)
+    size_t bytesAllocated = 0;                // estimated bytes of buckets, bitmaps, nodes and filter
+    size_t filterBytes = 0;                   // bytes of the filter, 0 without one
+    uint64_t successfulLookups = 0;
+    double averageSuccessfulProbes = 0;
+    uint64_t maxSuccessfulProbes = 0;
+    uint64_t failedLookups = 0;
+    double averageFailedProbes = 0;
+    uint64_t maxFailedProbes = 0;
+    uint64_t rehashCount = 0;
+    double rehashSeconds = 0;
+
+    /**
+     * Copy the recorded counters, nothing to copy from NoHashTableStats
+     */
+    void addRecorded(const NoHashTableStats&) {}
+
+    void addRecorded(const HashTableStats& stats)
+    {
+        successfulLookups = stats.successfulLookups;
+        averageSuccessfulProbes = stats.successfulLookups == 0 ? 0 :
+            (double)stats.successfulProbes / (double)stats.successfulLookups;
+        maxSuccessfulProbes = stats.maxSuccessfulProbes;
+        failedLookups = stats.failedLookups;
+        averageFailedProbes = stats.failedLookups == 0 ? 0 :
+            (double)stats.failedProbes / (double)stats.failedLookups;
+        maxFailedProbes = stats.maxFailedProbes;
+        rehashCount = stats.rehashCount;
+        rehashSeconds = stats.rehashSeconds;
+    }
+
+    /**
+     * @return the report as a single JSON object
+     */
+    std::string toJson() const
+    {
+        std::ostringstream out;
+        out << "{\"size\":" << size
+            << ",\"bucketSize\":" << bucketSize
+            << ",\"loadFactor\":" << loadFactor
+            << ",\"maxLoadFactor\":" << maxLoadFactor
+            << ",\"chainLengthHistogram\":[";
+        for (size_t i = 0; i < chainLengthHistogram.size(); i++)
+        {
+            out << (i == 0 ? "" : ",") << chainLengthHistogram[i];
+        }
+        out << "],\"maxChainLength\":" << maxChainLength
+            << ",\"hotBucketFraction\":" << hotBucketFraction
+            << ",\"bytesAllocated\":" << bytesAllocated
+            << ",\"filterBytes\":" << filterBytes
+            << ",\"successfulLookups\":" << successfulLookups
+            << ",\"averageSuccessfulProbes\":" << averageSuccessfulProbes
+            << ",\"maxSuccessfulProbes\":" << maxSuccessfulProbes
+            << ",\"failedLookups\":" << failedLookups
+            << ",\"averageFailedProbes\":" << averageFailedProbes
+            << ",\"maxFailedProbes\":" << maxFailedProbes
+            << ",\"rehashCount\":" << rehashCount
+            << ",\"rehashSeconds\":" << rehashSeconds
+            << "}";
+        return out.str();
+    }
+};
+
+#endif //VE281P2_HASHTABLE_STATS_HPP
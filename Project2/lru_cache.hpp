@@ -0,0 +1,354 @@
+#ifndef VE281P2_LRU_CACHE_HPP
+#define VE281P2_LRU_CACHE_HPP
+#include "hashtable.hpp"
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+
+/**
+ * Weigh of LruCache that charges every entry its node only
+ */
+struct NodeOnlyWeigh
+{
+    template <typename K, typename V>
+    size_t operator()(const K&, const V&) const { return 0; }
+};
+
+struct CacheStats
+{
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+};
+
+/**
+ * A cache bounded by a number of entries and optionally by bytes, evicting the least recently used entry
+ * The recency list is intrusive: every entry of the HashTable holds the pointers to its neighbours,
+ * which stay valid because HashTable never moves a node, so a hit costs one lookup and no allocation
+ * Not thread safe, see ShardedLruCache
+ * @tparam Key          key type
+ * @tparam Value        data type
+ * @tparam Hash         function object, return the hash value of a key
+ * @tparam KeyEqual     function object, return whether two keys are the same
+ * @tparam Weigh        function object, return the bytes an entry owns outside its node (e.g. string contents)
+ */
+template <
+    typename Key, typename Value,
+    typename Hash = std::hash<Key>,
+    typename KeyEqual = std::equal_to<Key>,
+    typename Weigh = NodeOnlyWeigh
+>
+class LruCache
+{
+protected:
+    struct Entry;
+    typedef HashTable<Key, Entry, Hash, KeyEqual> Table;
+    typedef typename Table::HashNode Node;
+
+    struct Entry
+    {
+        Value value;
+        Node* prev = nullptr; // more recently used
+        Node* next = nullptr; // less recently used
+        size_t bytes = 0;     // charged against maxBytes
+
+        template <typename V>
+        explicit Entry(V&& value) : value(std::forward<V>(value)) {}
+    };
+
+    static constexpr size_t NODE_BYTES = sizeof(typename Table::StoredNode) + sizeof(void*);
+
+    Table table;
+    Node* head = nullptr; // most recently used
+    Node* tail = nullptr; // least recently used
+    size_t capacity;      // maximum number of entries
+    size_t maxBytes;      // maximum bytes of the entries, 0 for no limit
+    size_t bytes = 0;     // bytes of the entries
+    CacheStats stats;
+    Weigh weigh;
+
+    void unlink(Node* node)
+    {
+        Entry& entry = node->second;
+        (entry.prev ? entry.prev->second.next : head) = entry.next;
+        (entry.next ? entry.next->second.prev : tail) = entry.prev;
+        entry.prev = entry.next = nullptr;
+    }
+
+    void pushFront(Node* node)
+    {
+        node->second.next = head;
+        (head ? head->second.prev : tail) = node;
+        head = node;
+    }
+
+    void touch(Node* node)
+    {
+        if (node == head) return;
+        unlink(node);
+        pushFront(node);
+    }
+
+    bool overBound() const
+    {
+        return table.size() > capacity || (maxBytes != 0 && bytes > maxBytes);
+    }
+
+    /**
+     * Evict from the tail until the bounds hold, the most recent entry is never evicted
+     */
+    void evict()
+    {
+        while (overBound() && tail != head)
+        {
+            Node* victim = tail;
+            unlink(victim);
+            bytes -= victim->second.bytes;
+            table.erase(victim->first);
+            stats.evictions++;
+        }
+    }
+
+public:
+    /**
+     * @param capacity maximum number of entries
+     * @param maxBytes maximum bytes of the entries (nodes and Weigh), 0 for no limit
+     * @throw std::range_error if capacity is 0
+     */
+    explicit LruCache(size_t capacity, size_t maxBytes = 0) : capacity(capacity), maxBytes(maxBytes), weigh(Weigh())
+    {
+        if (capacity == 0)
+        {
+            throw std::range_error("invalid capacity!");
+        }
+        table.reserve(capacity + 1);
+    }
+
+    LruCache(const LruCache&) = delete;
+    LruCache& operator=(const LruCache&) = delete;
+
+    /**
+     * Look up key and mark it as the most recently used
+     * Time Complexity: O(k)
+     * @return a pointer to the cached value, valid until the next put, or nullptr on a miss
+     */
+    Value* get(const Key& key)
+    {
+        auto it = table.find(key);
+        if (it == table.end())
+        {
+            stats.misses++;
+            return nullptr;
+        }
+        stats.hits++;
+        Node* node = &*it;
+        touch(node);
+        return &node->second.value;
+    }
+
+    /**
+     * Time Complexity: O(k)
+     * @return whether key was cached, if so its value is copied into value
+     */
+    bool get(const Key& key, Value& value)
+    {
+        Value* cached = get(key);
+        if (cached == nullptr) return false;
+        value = *cached;
+        return true;
+    }
+
+    /**
+     * Look up key without counting it or changing its recency
+     */
+    bool contains(const Key& key)
+    {
+        return table.contains(key);
+    }
+
+    /**
+     * Insert or replace the value of key, mark it as the most recently used,
+     * then evict the least recently used entries until both bounds hold
+     * Time Complexity: O(k), amortized over the evictions
+     */
+    template <typename V>
+    void put(const Key& key, V&& value)
+    {
+        auto result = table.tryEmplace(key, std::forward<V>(value));
+        Node* node = &*result.first;
+        Entry& entry = node->second;
+        if (result.second)
+        {
+            pushFront(node);
+        }
+        else
+        {
+            entry.value = std::forward<V>(value);
+            bytes -= entry.bytes;
+            touch(node);
+        }
+        entry.bytes = NODE_BYTES + weigh(node->first, entry.value);
+        bytes += entry.bytes;
+        evict();
+    }
+
+    /**
+     * Time Complexity: O(k)
+     * @return whether key was cached
+     */
+    bool erase(const Key& key)
+    {
+        auto it = table.find(key);
+        if (it == table.end()) return false;
+        Node* node = &*it;
+        unlink(node);
+        bytes -= node->second.bytes;
+        table.erase(it);
+        return true;
+    }
+
+    void clear()
+    {
+        table.clear();
+        head = tail = nullptr;
+        bytes = 0;
+    }
+
+    size_t size() const { return table.size(); }
+
+    size_t getCapacity() const { return capacity; }
+
+    /**
+     * @return bytes charged for the cached entries
+     */
+    size_t getBytes() const { return bytes; }
+
+    CacheStats getStats() const { return stats; }
+
+    void resetStats() { stats = CacheStats(); }
+};
+
+/**
+ * LruCache for concurrent use: keys are spread over independently locked shards by their hash,
+ * so threads only contend when they hit the same shard
+ * The bounds and the recency order are per shard, each shard holds capacity / shards entries
+ * @tparam Key          key type
+ * @tparam Value        data type, copied out by get
+ * @tparam Hash         function object, return the hash value of a key
+ * @tparam KeyEqual     function object, return whether two keys are the same
+ * @tparam Weigh        function object, return the bytes an entry owns outside its node
+ */
+template <
+    typename Key, typename Value,
+    typename Hash = std::hash<Key>,
+    typename KeyEqual = std::equal_to<Key>,
+    typename Weigh = NodeOnlyWeigh
+>
+class ShardedLruCache
+{
+protected:
+    typedef LruCache<Key, Value, Hash, KeyEqual, Weigh> Cache;
+
+    struct alignas(64) Shard
+    {
+        std::mutex lock;
+        std::unique_ptr<Cache> cache;
+    };
+
+    std::unique_ptr<Shard[]> shards;
+    size_t shardCount;
+    unsigned shift; // the shard of a hash value is its mixed top bits
+    Hash hash;
+
+    Shard& shardOf(const Key& key) const
+    {
+        if (shardCount == 1) return shards[0];
+        return shards[((uint64_t)hash(key) * 0x9E3779B97F4A7C15ULL) >> shift];
+    }
+
+public:
+    /**
+     * @param capacity maximum number of entries, divided among the shards
+     * @param maxBytes maximum bytes of the entries, divided among the shards, 0 for no limit
+     * @param shards number of shards, rounded up to a power of two
+     * @throw std::range_error if capacity is 0
+     */
+    explicit ShardedLruCache(size_t capacity, size_t maxBytes = 0, size_t shards = 16) : hash(Hash())
+    {
+        if (capacity == 0)
+        {
+            throw std::range_error("invalid capacity!");
+        }
+        unsigned bits = 0;
+        while (((size_t)1 << bits) < shards && ((size_t)1 << bits) < capacity) bits++;
+        shardCount = (size_t)1 << bits;
+        shift = 64 - bits;
+        this->shards.reset(new Shard[shardCount]);
+        for (size_t i = 0; i < shardCount; i++)
+        {
+            this->shards[i].cache.reset(new Cache((capacity + shardCount - 1) / shardCount,
+                                                  (maxBytes + shardCount - 1) / shardCount));
+        }
+    }
+
+    /**
+     * Time Complexity: O(k)
+     * @return whether key was cached, if so its value is copied into value
+     */
+    bool get(const Key& key, Value& value)
+    {
+        Shard& shard = shardOf(key);
+        std::lock_guard<std::mutex> guard(shard.lock);
+        return shard.cache->get(key, value);
+    }
+
+    template <typename V>
+    void put(const Key& key, V&& value)
+    {
+        Shard& shard = shardOf(key);
+        std::lock_guard<std::mutex> guard(shard.lock);
+        shard.cache->put(key, std::forward<V>(value));
+    }
+
+    bool erase(const Key& key)
+    {
+        Shard& shard = shardOf(key);
+        std::lock_guard<std::mutex> guard(shard.lock);
+        return shard.cache->erase(key);
+    }
+
+    /**
+     * Time Complexity: O(shards), not a consistent snapshot under concurrent updates
+     */
+    size_t size() const
+    {
+        size_t total = 0;
+        for (size_t i = 0; i < shardCount; i++)
+        {
+            std::lock_guard<std::mutex> guard(shards[i].lock);
+            total += shards[i].cache->size();
+        }
+        return total;
+    }
+
+    CacheStats getStats() const
+    {
+        CacheStats total;
+        for (size_t i = 0; i < shardCount; i++)
+        {
+            std::lock_guard<std::mutex> guard(shards[i].lock);
+            CacheStats s = shards[i].cache->getStats();
+            total.hits += s.hits;
+            total.misses += s.misses;
+            total.evictions += s.evictions;
+        }
+        return total;
+    }
+
+    size_t getShardCount() const { return shardCount; }
+};
+
+#endif //VE281P2_LRU_CACHE_HPP
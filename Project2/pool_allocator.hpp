@@ -0,0 +1,222 @@
+#ifndef VE281P2_POOL_ALLOCATOR_HPP
+#define VE281P2_POOL_ALLOCATOR_HPP
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <vector>
+
+/**
+ * A pool of fixed-size slots carved out of large chunks
+ * The slot size is fixed by the first pooled allocation, larger or
+ * over-aligned requests go to operator new directly
+ * PoolAllocator only pools single objects, so that the slot size is that of a node
+ * A freed slot goes on a free list and is reused by the next allocation,
+ * chunks are only returned by release or when the pool is destroyed
+ */
+class NodePool
+{
+private:
+    struct FreeSlot
+    {
+        FreeSlot* next;
+    };
+
+    static constexpr size_t MIN_CHUNK_SLOTS = 64;    // slots in the first chunk
+    static constexpr size_t MAX_CHUNK_SLOTS = 65536; // chunks double in size up to this
+
+    std::vector<void*> chunks;    // every chunk allocated so far
+    FreeSlot* freeList = nullptr; // slots freed by deallocate
+    char* cursor = nullptr;       // next never used slot in the last chunk
+    char* chunkEnd = nullptr;     // end of the last chunk
+    size_t slotSize = 0;          // 0 until the first pooled allocation
+    size_t chunkSlots = MIN_CHUNK_SLOTS;
+    size_t liveSlots = 0;         // slots handed out and not yet freed
+
+    bool pooled(size_t size, size_t align) const
+    {
+        return size <= slotSize && align <= alignof(std::max_align_t);
+    }
+
+    void addChunk()
+    {
+        char* chunk = static_cast<char*>(::operator new(slotSize * chunkSlots));
+        chunks.push_back(chunk);
+        cursor = chunk;
+        chunkEnd = chunk + slotSize * chunkSlots;
+        if (chunkSlots < MAX_CHUNK_SLOTS) chunkSlots *= 2;
+    }
+
+public:
+    /**
+     * operator new, with the alignment asked for when it is above the default
+     */
+    static void* allocateUnpooled(size_t size, size_t align)
+    {
+        if (align > __STDCPP_DEFAULT_NEW_ALIGNMENT__) return ::operator new(size, std::align_val_t(align));
+        return ::operator new(size);
+    }
+
+    static void deallocateUnpooled(void* p, size_t align)
+    {
+        if (align > __STDCPP_DEFAULT_NEW_ALIGNMENT__) ::operator delete(p, std::align_val_t(align));
+        else ::operator delete(p);
+    }
+
+    NodePool() = default;
+    NodePool(const NodePool&) = delete;
+    NodePool& operator=(const NodePool&) = delete;
+
+    ~NodePool()
+    {
+        for (void* chunk : chunks)
+        {
+            ::operator delete(chunk);
+        }
+    }
+
+    /**
+     * Time Complexity: O(1) amortized
+     * @return a slot of at least size bytes
+     */
+    void* allocate(size_t size, size_t align)
+    {
+        if (slotSize == 0 && align <= alignof(std::max_align_t))
+        {
+            // round up so that every slot in a chunk stays aligned
+            size_t unit = alignof(std::max_align_t);
+            slotSize = (std::max(size, sizeof(FreeSlot)) + unit - 1) / unit * unit;
+        }
+        if (!pooled(size, align))
+        {
+            return allocateUnpooled(size, align);
+        }
+        liveSlots++;
+        if (freeList != nullptr)
+        {
+            FreeSlot* slot = freeList;
+            freeList = slot->next;
+            return slot;
+        }
+        if (cursor == chunkEnd)
+        {
+            addChunk();
+        }
+        void* slot = cursor;
+        cursor += slotSize;
+        return slot;
+    }
+
+    /**
+     * Time Complexity: O(1)
+     * @param p a pointer returned by allocate(size, align)
+     */
+    void deallocate(void* p, size_t size, size_t align)
+    {
+        if (!pooled(size, align))
+        {
+            deallocateUnpooled(p, align);
+            return;
+        }
+        liveSlots--;
+        FreeSlot* slot = static_cast<FreeSlot*>(p);
+        slot->next = freeList;
+        freeList = slot;
+    }
+
+    /**
+     * Return every chunk at once, instead of keeping them for reuse
+     * Does nothing while any slot is still live
+     * Time Complexity: O(number of chunks)
+     */
+    void release()
+    {
+        if (liveSlots != 0) return;
+        for (void* chunk : chunks)
+        {
+            ::operator delete(chunk);
+        }
+        chunks.clear();
+        freeList = nullptr;
+        cursor = chunkEnd = nullptr;
+        chunkSlots = MIN_CHUNK_SLOTS;
+    }
+
+    size_t live() const { return liveSlots; }
+
+    /**
+     * @return bytes held in chunks, used or not
+     */
+    size_t reserved() const
+    {
+        size_t slots = 0;
+        for (size_t i = 0, n = MIN_CHUNK_SLOTS; i < chunks.size(); i++)
+        {
+            slots += n;
+            if (n < MAX_CHUNK_SLOTS) n *= 2;
+        }
+        return slots * slotSize;
+    }
+};
+
+/**
+ * A standard allocator backed by a shared NodePool, for the nodes of HashTable
+ * Copies and rebinds share the pool, so every bucket of a table allocates from
+ * one pool and nodes can be spliced between buckets
+ * Arrays (n > 1) are not pooled, they go to operator new directly
+ * A copied container gets a new pool (select_on_container_copy_construction)
+ * The pool is not thread safe
+ * @tparam T value type
+ */
+template <typename T>
+class PoolAllocator
+{
+private:
+    template <typename U> friend class PoolAllocator;
+
+    std::shared_ptr<NodePool> pool;
+
+public:
+    typedef T value_type;
+    typedef std::false_type propagate_on_container_copy_assignment;
+    typedef std::true_type propagate_on_container_move_assignment;
+    typedef std::true_type propagate_on_container_swap;
+    typedef std::false_type is_always_equal;
+
+    PoolAllocator() : pool(std::make_shared<NodePool>()) {}
+
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U>& that) : pool(that.pool) {}
+
+    T* allocate(size_t n)
+    {
+        if (n != 1) return static_cast<T*>(NodePool::allocateUnpooled(n * sizeof(T), alignof(T)));
+        return static_cast<T*>(pool->allocate(sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T* p, size_t n)
+    {
+        if (n != 1) NodePool::deallocateUnpooled(p, alignof(T));
+        else pool->deallocate(p, sizeof(T), alignof(T));
+    }
+
+    PoolAllocator select_on_container_copy_construction() const
+    {
+        return PoolAllocator();
+    }
+
+    /**
+     * Bulk release of the shared pool, see NodePool::release
+     */
+    void release() const { pool->release(); }
+
+    const NodePool& getPool() const { return *pool; }
+
+    template <typename U>
+    bool operator==(const PoolAllocator<U>& that) const { return pool == that.pool; }
+
+    template <typename U>
+    bool operator!=(const PoolAllocator<U>& that) const { return pool != that.pool; }
+};
+
+#endif //VE281P2_POOL_ALLOCATOR_HPP
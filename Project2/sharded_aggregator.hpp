@@ -0,0 +1,206 @@
+#ifndef VE281P2_SHARDED_AGGREGATOR_HPP
+#define VE281P2_SHARDED_AGGREGATOR_HPP
+#include "hashtable.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/**
+ * Group-by aggregation over many threads without any shared state until the end
+ * Every thread aggregates into its own Shard, which is split into partitions by the high bits of
+ * the (Fibonacci mixed) hash of the key. merge then combines partition p of every shard, for each p
+ * on some thread, and the disjoint results are bulk loaded into one HashTable
+ * @tparam Key          key type
+ * @tparam Value        aggregated data type, default constructible
+ * @tparam Reduce       function object, combine two values of the same key into one, e.g. std::plus
+ * @tparam Hash         function object, return the hash value of a key
+ * @tparam KeyEqual     function object, return whether two keys are the same
+ */
+template <
+    typename Key, typename Value,
+    typename Reduce = std::plus<Value>,
+    typename Hash = std::hash<Key>,
+    typename KeyEqual = std::equal_to<Key>
+>
+class ShardedAggregator
+{
+public:
+    typedef HashTable<Key, Value, Hash, KeyEqual> Table;
+
+    /**
+     * The partitions of one thread, only to be used by that thread
+     */
+    class alignas(64) Shard
+    {
+    private:
+        friend class ShardedAggregator;
+
+        std::vector<Table> partitions;
+        unsigned shift; // the partition of a hash value is its mixed top bits
+        Hash hash;
+        Reduce reduce;
+
+        Shard(size_t partitionCount, unsigned shift, const Reduce& reduce) :
+            partitions(partitionCount), shift(shift), hash(Hash()), reduce(reduce) {}
+
+    public:
+        Table& partitionOf(const Key& key)
+        {
+            if (partitions.size() == 1) return partitions[0];
+            return partitions[((uint64_t)hash(key) * 0x9E3779B97F4A7C15ULL) >> shift];
+        }
+
+        /**
+         * The accumulated value of key in this shard, default constructed on first access
+         * e.g. shard[key]++ for a count
+         * Time Complexity: Amortized O(k)
+         */
+        Value& operator[](const Key& key)
+        {
+            return partitionOf(key)[key];
+        }
+
+        /**
+         * Combine value into the accumulated value of key with Reduce
+         * Time Complexity: Amortized O(k)
+         */
+        void add(const Key& key, const Value& value)
+        {
+            auto result = partitionOf(key).tryEmplace(key, value);
+            if (!result.second)
+            {
+                result.first->second = reduce(result.first->second, value);
+            }
+        }
+
+        /**
+         * @return the number of keys in this shard
+         */
+        size_t size() const
+        {
+            size_t total = 0;
+            for (const Table& partition : partitions)
+            {
+                total += partition.size();
+            }
+            return total;
+        }
+    };
+
+private:
+    std::vector<Shard> shards;
+    Reduce reduce;
+
+    template <typename F>
+    static void runThreads(unsigned threads, F f)
+    {
+        std::vector<std::thread> workers;
+        for (unsigned t = 1; t < threads; t++)
+        {
+            workers.emplace_back(f, t);
+        }
+        f(0u);
+        for (auto& w : workers) w.join();
+    }
+
+public:
+    /**
+     * @param threads number of shards, one for each thread
+     * @param partitionBits log2 of the number of partitions per shard, 0 to choose about 4 per thread
+     * @param reduce
+     */
+    explicit ShardedAggregator(unsigned threads = std::thread::hardware_concurrency(),
+                               unsigned partitionBits = 0, const Reduce& reduce = Reduce()) : reduce(reduce)
+    {
+        if (threads == 0) threads = 1;
+        if (partitionBits == 0)
+        {
+            while (((size_t)1 << partitionBits) < (size_t)threads * 4) partitionBits++;
+        }
+        partitionBits = std::min(partitionBits, 16u);
+        shards.reserve(threads);
+        for (unsigned t = 0; t < threads; t++)
+        {
+            shards.push_back(Shard((size_t)1 << partitionBits, 64 - partitionBits, reduce));
+        }
+    }
+
+    ShardedAggregator(const ShardedAggregator&) = delete;
+    ShardedAggregator& operator=(const ShardedAggregator&) = delete;
+
+    /**
+     * @param thread in [0, getThreadCount())
+     * @return the shard of thread
+     */
+    Shard& shard(unsigned thread) { return shards[thread]; }
+
+    unsigned getThreadCount() const { return (unsigned)shards.size(); }
+
+    size_t getPartitionCount() const { return shards[0].partitions.size(); }
+
+    /**
+     * Combine every shard into one HashTable, the shards are left empty
+     * Partition p of every shard is reduced into the largest one, partitions in parallel,
+     * then the partitions (disjoint by construction) are copied out and bulk loaded
+     * Must not run concurrently with any use of the shards
+     * Time Complexity: O(nk + number of partitions * threads), divided by threads
+     * @param threads number of threads used to merge
+     * @return the aggregated table
+     */
+    Table merge(unsigned threads = std::thread::hardware_concurrency())
+    {
+        size_t partitionCount = getPartitionCount();
+        threads = std::max(1u, (unsigned)std::min<size_t>(threads, partitionCount));
+        std::vector<Table*> merged(partitionCount);
+        runThreads(threads, [&](unsigned t) {
+            for (size_t p = t; p < partitionCount; p += threads)
+            {
+                Table* target = &shards[0].partitions[p];
+                for (Shard& s : shards)
+                {
+                    if (s.partitions[p].size() > target->size()) target = &s.partitions[p];
+                }
+                for (Shard& s : shards)
+                {
+                    Table& source = s.partitions[p];
+                    if (&source == target) continue;
+                    for (auto it = source.begin(); it != source.end(); ++it)
+                    {
+                        auto result = target->tryEmplace(it->first, it->second);
+                        if (!result.second)
+                        {
+                            result.first->second = reduce(result.first->second, it->second);
+                        }
+                    }
+                    source.clear();
+                }
+                merged[p] = target;
+            }
+        });
+
+        std::vector<size_t> offsets(partitionCount + 1, 0);
+        for (size_t p = 0; p < partitionCount; p++)
+        {
+            offsets[p + 1] = offsets[p] + merged[p]->size();
+        }
+        std::vector<std::pair<Key, Value>> elements(offsets[partitionCount]);
+        runThreads(threads, [&](unsigned t) {
+            for (size_t p = t; p < partitionCount; p += threads)
+            {
+                size_t i = offsets[p];
+                for (auto it = merged[p]->begin(); it != merged[p]->end(); ++it)
+                {
+                    elements[i].first = it->first;
+                    elements[i++].second = it->second;
+                }
+                merged[p]->clear();
+            }
+        });
+        return Table(elements.begin(), elements.end(), threads);
+    }
+};
+
+#endif //VE281P2_SHARDED_AGGREGATOR_HPP
@@ -0,0 +1,483 @@
+#ifndef VE281P2_SNAPSHOT_HPP
+#define VE281P2_SNAPSHOT_HPP
+#include "hash_prime.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * On-disk snapshot of a hashtable with trivially copyable keys and values
+ * Layout of a snapshot file, every section aligned to SNAPSHOT_ALIGNMENT bytes:
+ * - SnapshotHeader
+ * - bucketCount + 1 offsets (uint64_t): the entries of bucket b are [offsets[b], offsets[b + 1])
+ * - elementCount entries {hash, key, value}, sorted by bucket
+ * A snapshot is written once by SnapshotBuilder and opened read-only by MappedHashTable,
+ * which looks keys up directly in the mapped pages
+ * The bucket of a hash is hash % bucketCount (computed with fastmod), so the snapshot must be
+ * read with the same Hash that wrote it, on a machine of the same byte order
+ */
+static constexpr char SNAPSHOT_MAGIC[8] = {'V', 'E', '2', '8', '1', 'H', 'T', '\0'};
+static constexpr uint32_t SNAPSHOT_VERSION = 2; // 2: the checksum covers the header
+static constexpr uint32_t SNAPSHOT_BYTE_ORDER = 0x01020304;
+static constexpr size_t SNAPSHOT_ALIGNMENT = 64;
+
+struct SnapshotHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint32_t keySize;
+    uint32_t valueSize;
+    uint64_t entrySize;
+    uint64_t elementCount;
+    uint64_t bucketCount;
+    uint64_t offsetsOffset; // byte offset of the bucket offsets in the file
+    uint64_t entriesOffset; // byte offset of the entries in the file
+    uint64_t fileSize;
+    uint64_t checksum;      // of the whole file, with this field read as 0
+};
+
+/**
+ * A 64-bit checksum read 8 bytes at a time, with a murmur-style finalizer
+ * The data can be added in pieces of any size, whose total size is given first
+ * Time Complexity: O(size)
+ */
+class SnapshotChecksum
+{
+private:
+    uint64_t h;
+    unsigned char pending[8]; // the bytes of an incomplete word
+    size_t pendingSize = 0;
+
+    void addWord(const unsigned char* data)
+    {
+        uint64_t word;
+        std::memcpy(&word, data, 8);
+        h = (h ^ word) * 0xFF51AFD7ED558CCDULL;
+        h ^= h >> 29;
+    }
+
+public:
+    explicit SnapshotChecksum(uint64_t totalSize) : h(0x9E3779B97F4A7C15ULL ^ totalSize) {}
+
+    void add(const void* data, size_t size)
+    {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        if (pendingSize > 0)
+        {
+            size_t count = std::min(size, 8 - pendingSize);
+            std::memcpy(pending + pendingSize, bytes, count);
+            pendingSize += count;
+            bytes += count;
+            size -= count;
+            if (pendingSize < 8) return;
+            addWord(pending);
+            pendingSize = 0;
+        }
+        for (; size >= 8; bytes += 8, size -= 8)
+        {
+            addWord(bytes);
+        }
+        std::memcpy(pending, bytes, size);
+        pendingSize = size;
+    }
+
+    uint64_t value() const
+    {
+        uint64_t x = h;
+        for (size_t i = 0; i < pendingSize; i++)
+        {
+            x = (x ^ pending[i]) * 0xC4CEB9FE1A85EC53ULL;
+        }
+        x ^= x >> 33;
+        x *= 0xFF51AFD7ED558CCDULL;
+        x ^= x >> 33;
+        return x;
+    }
+};
+
+/**
+ * The checksum of a whole snapshot file, computed as if its checksum field were 0
+ */
+inline uint64_t snapshotChecksum(const SnapshotHeader& header, const unsigned char* body, size_t bodySize)
+{
+    SnapshotHeader zeroed = header;
+    zeroed.checksum = 0;
+    SnapshotChecksum checksum(sizeof(SnapshotHeader) + bodySize);
+    checksum.add(&zeroed, sizeof(zeroed));
+    checksum.add(body, bodySize);
+    return checksum.value();
+}
+
+inline size_t snapshotAlign(size_t offset)
+{
+    return (offset + SNAPSHOT_ALIGNMENT - 1) / SNAPSHOT_ALIGNMENT * SNAPSHOT_ALIGNMENT;
+}
+
+/**
+ * An entry of a snapshot, the full hash is kept to skip most KeyEqual calls
+ */
+template <typename Key, typename Value>
+struct SnapshotEntry
+{
+    uint64_t hashValue;
+    Key key;
+    Value value;
+};
+
+/**
+ * Collects <key, value> pairs, then writes them as a snapshot
+ * The number of buckets is computed from the number of distinct keys at write time,
+ * so the snapshot has the load factor asked for, up to rounding the bucket count down
+ * @tparam Key          trivially copyable key type
+ * @tparam Value        trivially copyable data type
+ * @tparam Hash         function object, return the hash value of a key
+ * @tparam KeyEqual     function object, return whether two keys are the same
+ */
+template <
+    typename Key, typename Value,
+    typename Hash = std::hash<Key>,
+    typename KeyEqual = std::equal_to<Key>
+>
+class SnapshotBuilder
+{
+    static_assert(std::is_trivially_copyable<Key>::value, "snapshot keys must be trivially copyable");
+    static_assert(std::is_trivially_copyable<Value>::value, "snapshot values must be trivially copyable");
+
+public:
+    typedef SnapshotEntry<Key, Value> Entry;
+
+protected:
+    static constexpr size_t WRITE_BUFFER_BYTES = 1 << 16; // entries are written in pieces of about this size
+
+    std::vector<Entry> entries;
+    double loadFactor;
+    Hash hash;
+    KeyEqual keyEqual;
+
+    uint64_t bucketCountFor(size_t elementCount) const
+    {
+        return std::max<uint64_t>(1, (uint64_t)((double)elementCount / loadFactor));
+    }
+
+    /**
+     * Counting sort of the indices of the entries not dropped, by bucket
+     * Time Complexity: O(n + bucketCount)
+     * @param order set to the indices, in order of addition within a bucket
+     * @return the bucketCount + 1 offsets: the entries of bucket b are order[offsets[b] .. offsets[b + 1])
+     */
+    std::vector<uint64_t> groupByBucket(const std::vector<bool>& dropped, uint64_t bucketCount,
+                                        std::vector<size_t>& order) const
+    {
+        HashPrime::uint128_t magic = ~(HashPrime::uint128_t)0 / bucketCount + 1;
+        std::vector<uint64_t> offsets(bucketCount + 1, 0);
+        for (size_t i = 0; i < entries.size(); i++)
+        {
+            if (!dropped[i]) offsets[HashPrime::fastmod(entries[i].hashValue, magic, bucketCount) + 1]++;
+        }
+        for (uint64_t b = 0; b < bucketCount; b++)
+        {
+            offsets[b + 1] += offsets[b];
+        }
+        order.resize(offsets[bucketCount]);
+        std::vector<uint64_t> next(offsets.begin(), offsets.end() - 1);
+        for (size_t i = 0; i < entries.size(); i++)
+        {
+            if (!dropped[i]) order[next[HashPrime::fastmod(entries[i].hashValue, magic, bucketCount)]++] = i;
+        }
+        return offsets;
+    }
+
+public:
+    /**
+     * @param loadFactor elements per bucket of the written snapshot
+     * @throw std::range_error if the load factor is too small
+     */
+    explicit SnapshotBuilder(double loadFactor = 1.0) : loadFactor(loadFactor), hash(Hash()), keyEqual(KeyEqual())
+    {
+        if (loadFactor <= 1e-9)
+        {
+            throw std::range_error("invalid load factor!");
+        }
+    }
+
+    void reserve(size_t n) { entries.reserve(n); }
+
+    /**
+     * Add <key, value>, if the key is added more than once the last value is written
+     * Time Complexity: O(k)
+     */
+    void add(const Key& key, const Value& value)
+    {
+        Entry entry;
+        std::memset(&entry, 0, sizeof(entry)); // no uninitialized padding in the file
+        entry.hashValue = (uint64_t)hash(key);
+        entry.key = key;
+        entry.value = value;
+        entries.push_back(entry);
+    }
+
+    /**
+     * Add every element of a table with begin() / end() iterators of pairs, e.g. HashTable
+     */
+    template <typename Table>
+    void addAll(Table& table)
+    {
+        for (auto it = table.begin(); it != table.end(); ++it)
+        {
+            add(it->first, it->second);
+        }
+    }
+
+    size_t size() const { return entries.size(); }
+
+    /**
+     * Write the snapshot to path + ".tmp", then rename it to path,
+     * so that readers never see a partially written snapshot
+     * Besides the added entries, only an index and a bit per entry and an offset per bucket are held:
+     * the entries are streamed to the file through a fixed-size buffer, and the checksum
+     * is computed along the way and written into the header last
+     * Time Complexity: O(n) plus O(chain length) per element to drop duplicate keys
+     * @throw std::runtime_error if the file cannot be written
+     */
+    void write(const std::string& path) const
+    {
+        // group the entries by bucket of a first guess of the bucket count, to drop the duplicate keys
+        std::vector<bool> dropped(entries.size(), false);
+        std::vector<size_t> order;
+        std::vector<uint64_t> offsets = groupByBucket(dropped, bucketCountFor(entries.size()), order);
+        size_t kept = entries.size();
+        for (size_t b = 0; b + 1 < offsets.size(); b++)
+        {
+            // drop every entry whose key is added again later in its bucket
+            for (uint64_t i = offsets[b]; i < offsets[b + 1]; i++)
+            {
+                const Entry& entry = entries[order[i]];
+                for (uint64_t j = i + 1; j < offsets[b + 1]; j++)
+                {
+                    if (entries[order[j]].hashValue == entry.hashValue && keyEqual(entries[order[j]].key, entry.key))
+                    {
+                        dropped[order[i]] = true;
+                        kept--;
+                        break;
+                    }
+                }
+            }
+        }
+        uint64_t bucketCount = bucketCountFor(kept);
+        if (kept != entries.size())
+        {
+            offsets = groupByBucket(dropped, bucketCount, order);
+        }
+
+        SnapshotHeader header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+        header.version = SNAPSHOT_VERSION;
+        header.byteOrder = SNAPSHOT_BYTE_ORDER;
+        header.keySize = (uint32_t)sizeof(Key);
+        header.valueSize = (uint32_t)sizeof(Value);
+        header.entrySize = sizeof(Entry);
+        header.elementCount = kept;
+        header.bucketCount = bucketCount;
+        header.offsetsOffset = snapshotAlign(sizeof(SnapshotHeader));
+        header.entriesOffset = snapshotAlign(header.offsetsOffset + offsets.size() * sizeof(uint64_t));
+        header.fileSize = header.entriesOffset + kept * sizeof(Entry);
+
+        std::string tmpPath = path + ".tmp";
+        FILE* file = std::fopen(tmpPath.c_str(), "wb");
+        if (file == nullptr)
+        {
+            throw std::runtime_error("cannot open " + tmpPath);
+        }
+        SnapshotChecksum checksum(header.fileSize);
+        uint64_t written = 0;
+        bool ok = true;
+        auto put = [&](const void* data, size_t size) {
+            checksum.add(data, size);
+            ok = ok && std::fwrite(data, 1, size, file) == size;
+            written += size;
+        };
+        const unsigned char zeros[SNAPSHOT_ALIGNMENT] = {};
+        put(&header, sizeof(header));
+        put(zeros, header.offsetsOffset - written);
+        put(offsets.data(), offsets.size() * sizeof(uint64_t));
+        put(zeros, header.entriesOffset - written);
+        // entries are copied byte for byte, with the zeroed padding of add
+        std::vector<unsigned char> buffer(std::max<size_t>(1, WRITE_BUFFER_BYTES / sizeof(Entry)) * sizeof(Entry));
+        size_t buffered = 0;
+        for (size_t i : order)
+        {
+            std::memcpy(buffer.data() + buffered, &entries[i], sizeof(Entry));
+            buffered += sizeof(Entry);
+            if (buffered == buffer.size())
+            {
+                put(buffer.data(), buffered);
+                buffered = 0;
+            }
+        }
+        put(buffer.data(), buffered);
+        header.checksum = checksum.value();
+        ok = ok && std::fseek(file, (long)offsetof(SnapshotHeader, checksum), SEEK_SET) == 0 &&
+             std::fwrite(&header.checksum, sizeof(header.checksum), 1, file) == 1;
+        ok = std::fclose(file) == 0 && ok;
+        if (!ok || std::rename(tmpPath.c_str(), path.c_str()) != 0)
+        {
+            std::remove(tmpPath.c_str());
+            throw std::runtime_error("cannot write " + path);
+        }
+    }
+};
+
+/**
+ * A read-only hashtable on a memory-mapped snapshot, opening it costs O(1) besides the
+ * optional checksum, the pages are loaded by the OS on first access
+ * @tparam Key          trivially copyable key type
+ * @tparam Value        trivially copyable data type
+ * @tparam Hash         function object, must be the one the snapshot was written with
+ * @tparam KeyEqual     function object, return whether two keys are the same
+ */
+template <
+    typename Key, typename Value,
+    typename Hash = std::hash<Key>,
+    typename KeyEqual = std::equal_to<Key>
+>
+class MappedHashTable
+{
+    static_assert(std::is_trivially_copyable<Key>::value, "snapshot keys must be trivially copyable");
+    static_assert(std::is_trivially_copyable<Value>::value, "snapshot values must be trivially copyable");
+
+public:
+    typedef SnapshotEntry<Key, Value> Entry;
+
+protected:
+    void* mapping = MAP_FAILED;
+    size_t mappingSize = 0;
+    const SnapshotHeader* header = nullptr;
+    const uint64_t* offsets = nullptr;
+    const Entry* entries = nullptr;
+    HashPrime::uint128_t magic = 0; // fastmod magic of bucketCount
+    Hash hash;
+    KeyEqual keyEqual;
+
+    void fail(const std::string& path, const std::string& reason)
+    {
+        if (mapping != MAP_FAILED)
+        {
+            munmap(mapping, mappingSize);
+            mapping = MAP_FAILED;
+        }
+        throw std::runtime_error(path + ": " + reason);
+    }
+
+public:
+    /**
+     * Map a snapshot written by SnapshotBuilder
+     * @param path
+     * @param verify whether to check the checksum, which reads the whole file
+     * @throw std::runtime_error if the file cannot be mapped or is not a valid snapshot of this type
+     */
+    explicit MappedHashTable(const std::string& path, bool verify = true) : hash(Hash()), keyEqual(KeyEqual())
+    {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            fail(path, "cannot open");
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(SnapshotHeader))
+        {
+            close(fd);
+            fail(path, "not a snapshot");
+        }
+        mappingSize = (size_t)st.st_size;
+        mapping = mmap(nullptr, mappingSize, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (mapping == MAP_FAILED)
+        {
+            fail(path, "cannot map");
+        }
+        const unsigned char* base = static_cast<const unsigned char*>(mapping);
+        header = reinterpret_cast<const SnapshotHeader*>(base);
+        if (std::memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0)
+        {
+            fail(path, "not a snapshot");
+        }
+        if (header->version != SNAPSHOT_VERSION || header->byteOrder != SNAPSHOT_BYTE_ORDER)
+        {
+            fail(path, "unsupported snapshot version or byte order");
+        }
+        if (header->keySize != sizeof(Key) || header->valueSize != sizeof(Value) || header->entrySize != sizeof(Entry))
+        {
+            fail(path, "snapshot of another key or value type");
+        }
+        if (header->fileSize != mappingSize || header->bucketCount == 0 ||
+            header->offsetsOffset + (header->bucketCount + 1) * sizeof(uint64_t) > header->entriesOffset ||
+            header->entriesOffset + header->elementCount * sizeof(Entry) != header->fileSize)
+        {
+            fail(path, "truncated or corrupted snapshot");
+        }
+        if (verify && snapshotChecksum(*header, base + sizeof(SnapshotHeader), mappingSize - sizeof(SnapshotHeader)) !=
+                      header->checksum)
+        {
+            fail(path, "checksum mismatch");
+        }
+        offsets = reinterpret_cast<const uint64_t*>(base + header->offsetsOffset);
+        entries = reinterpret_cast<const Entry*>(base + header->entriesOffset);
+        magic = ~(HashPrime::uint128_t)0 / header->bucketCount + 1;
+        // lookups touch one bucket offset and a few entries each
+        madvise(mapping, mappingSize, MADV_RANDOM);
+    }
+
+    MappedHashTable(const MappedHashTable&) = delete;
+    MappedHashTable& operator=(const MappedHashTable&) = delete;
+
+    ~MappedHashTable()
+    {
+        if (mapping != MAP_FAILED)
+        {
+            munmap(mapping, mappingSize);
+        }
+    }
+
+    /**
+     * Time Complexity: O(k)
+     * @return a pointer to the value of key in the mapped pages, or nullptr if the key does not exist
+     */
+    const Value* find(const Key& key) const
+    {
+        uint64_t hashValue = (uint64_t)hash(key);
+        size_t bucket = HashPrime::fastmod(hashValue, magic, header->bucketCount);
+        for (uint64_t i = offsets[bucket]; i < offsets[bucket + 1]; i++)
+        {
+            if (entries[i].hashValue == hashValue && keyEqual(entries[i].key, key))
+            {
+                return &entries[i].value;
+            }
+        }
+        return nullptr;
+    }
+
+    bool contains(const Key& key) const { return find(key) != nullptr; }
+
+    size_t size() const { return header->elementCount; }
+
+    size_t bucketSize() const { return header->bucketCount; }
+
+    const Entry* begin() const { return entries; }
+
+    const Entry* end() const { return entries + header->elementCount; }
+};
+
+#endif //VE281P2_SNAPSHOT_HPP
@@ -0,0 +1,34 @@
+#ifndef VE281P2_TEST_CHECK_HPP
+#define VE281P2_TEST_CHECK_HPP
+#include <atomic>
+#include <cstdio>
+#include <string>
+
+/**
+ * The checks shared by the test_*.cpp programs
+ * Every failed check is printed, and checkSummary gives the exit status of main
+ */
+
+inline std::atomic<int> checkFailures(0); // atomic, so that threads may check as well
+
+inline void check(bool condition, const std::string& what)
+{
+    if (!condition)
+    {
+        std::printf("FAILED: %s\n", what.c_str());
+        checkFailures++;
+    }
+}
+
+/**
+ * Print how many checks failed
+ * @return 0 if none failed, 1 otherwise
+ */
+inline int checkSummary()
+{
+    int failed = checkFailures.load();
+    std::printf(failed == 0 ? "all checks passed\n" : "%d checks failed\n", failed);
+    return failed == 0 ? 0 : 1;
+}
+
+#endif //VE281P2_TEST_CHECK_HPP
@@ -0,0 +1,136 @@
+#include "concurrent_hashtable.hpp"
+#include "test_check.hpp"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <vector>
+using namespace std;
+
+// Usage: ./test_concurrent_hashtable [threads=8] [keys_per_thread=20000] [rounds=3]
+// Build with -pthread, and with -fsanitize=thread to check the memory ordering as well
+// Writer t owns the keys t, t + threads, t + 2 * threads, ..., so the result of every one of its operations
+// is known exactly, while the others insert and erase around it and resize the table (it starts with 1 bucket
+// per stripe). Readers check that any value they see belongs to the key they looked up.
+
+const long VERSIONS = 16; // a value is key * VERSIONS + version
+
+void check(bool condition, const char *what, long key)
+{
+    if (!condition) check(false, string(what) + ", key " + to_string(key));
+}
+
+typedef ConcurrentHashTable<long, long> table_type;
+
+/**
+ * Run rounds of inserts, reassignments, erases and computeIfAbsent on the keys of writer t
+ * @param expected set to the final value of each key of t, -1 if it is absent
+ */
+void writer(table_type &table, size_t t, size_t threads, size_t keys, size_t rounds, vector<long> &expected)
+{
+    expected.assign(keys, -1);
+    long value = 0;
+    for (size_t round = 0; round < rounds; round++)
+    {
+        for (size_t i = 0; i < keys; i++)
+        {
+            long key = (long)(t + threads * i);
+            long version = (long)(round * 4) % VERSIONS;
+            check(table.insertOrAssign(key, key * VERSIONS + version) == (expected[i] < 0),
+                  "insertOrAssign returned a wrong insertion flag", key);
+            expected[i] = key * VERSIONS + version;
+            check(table.find(key, value) && value == expected[i], "own insert not visible", key);
+        }
+        for (size_t i = round % 2; i < keys; i += 2)
+        {
+            long key = (long)(t + threads * i);
+            long version = (long)(round * 4 + 1) % VERSIONS;
+            check(!table.insertOrAssign(key, key * VERSIONS + version), "reassignment reported as insertion", key);
+            expected[i] = key * VERSIONS + version;
+            check(table.find(key, value) && value == expected[i], "own reassignment not visible", key);
+        }
+        for (size_t i = round % 3; i < keys; i += 3)
+        {
+            long key = (long)(t + threads * i);
+            check(table.erase(key), "erase of a present key failed", key);
+            check(!table.contains(key), "erased key still found", key);
+            check(!table.erase(key), "second erase succeeded", key);
+            expected[i] = -1;
+        }
+        for (size_t i = 0; i < keys; i += 5)
+        {
+            long key = (long)(t + threads * i);
+            long version = (long)(round * 4 + 2) % VERSIONS;
+            bool computed = false;
+            long result = table.computeIfAbsent(key, [&](long k) {
+                computed = true;
+                return k * VERSIONS + version;
+            });
+            check(computed == (expected[i] < 0), "computeIfAbsent computed for a present key or not for an absent one", key);
+            if (expected[i] < 0) expected[i] = key * VERSIONS + version;
+            check(result == expected[i], "computeIfAbsent returned a wrong value", key);
+        }
+    }
+}
+
+/**
+ * Look up random keys until stop, every value found must be one written for that key
+ */
+void reader(const table_type &table, long key_range, unsigned seed, atomic<bool> &stop)
+{
+    mt19937_64 gen(seed);
+    long value = 0;
+    while (!stop.load())
+    {
+        long key = (long)(gen() % (unsigned long)key_range);
+        if (table.find(key, value))
+        {
+            check(value / VERSIONS == key, "found the value of another key", key);
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    size_t threads = argc > 1 ? strtoul(argv[1], nullptr, 10) : 8;
+    size_t keys = argc > 2 ? strtoul(argv[2], nullptr, 10) : 20000;
+    size_t rounds = argc > 3 ? strtoul(argv[3], nullptr, 10) : 3;
+
+    table_type table;
+    vector<vector<long>> expected(threads);
+    atomic<bool> stop(false);
+    vector<thread> readers, writers;
+    for (unsigned r = 0; r < 2; r++)
+    {
+        readers.emplace_back(reader, cref(table), (long)(threads * keys), r + 1, ref(stop));
+    }
+    for (size_t t = 0; t < threads; t++)
+    {
+        writers.emplace_back(writer, ref(table), t, threads, keys, rounds, ref(expected[t]));
+    }
+    for (auto &w : writers) w.join();
+    stop = true;
+    for (auto &r : readers) r.join();
+
+    size_t present = 0;
+    long value = 0;
+    for (size_t t = 0; t < threads; t++)
+    {
+        for (size_t i = 0; i < keys; i++)
+        {
+            long key = (long)(t + threads * i);
+            bool found = table.find(key, value);
+            check(found == (expected[t][i] >= 0), "final presence differs from the owner's operations", key);
+            check(!found || value == expected[t][i], "final value differs from the owner's last write", key);
+            present += found;
+        }
+    }
+    check(table.size() == present, "size differs from the number of keys present", (long)table.size());
+    for (long key = (long)(threads * keys); key < (long)(threads * keys) + 1000; key++)
+    {
+        check(!table.contains(key), "key never inserted found", key);
+    }
+
+    return checkSummary();
+}
@@ -0,0 +1,69 @@
+#include "hash_functions.hpp"
+#include "test_check.hpp"
+#include <cstdio>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+using namespace std;
+
+// Checks of FastStringHash and SeededHash, build it with and without -mavx2
+
+string swap_stripes(string s, size_t a, size_t b)
+{
+    const size_t stripe = HashFunctions::STRIPE_SIZE;
+    for (size_t i = 0; i < stripe; i++)
+    {
+        swap(s[a * stripe + i], s[b * stripe + i]);
+    }
+    return s;
+}
+
+template <typename Hash>
+void check_stripe_order(const char *name, const Hash &hash, const string &s)
+{
+    size_t stripes = s.size() / HashFunctions::STRIPE_SIZE;
+    size_t block = HashFunctions::STRIPES_PER_SCRAMBLE;
+    vector<pair<size_t, size_t>> swaps = {{0, 1}, {1, 2}, {0, block - 1}, {3, block + 3}, {0, stripes - 1}};
+    for (auto &sw : swaps)
+    {
+        if (sw.second >= stripes) continue;
+        string swapped = swap_stripes(s, sw.first, sw.second);
+        if (swapped == s) continue;
+        check(hash(swapped) != hash(s), string(name) + ": stripes " + to_string(sw.first) + " and " +
+              to_string(sw.second) + " of " + to_string(s.size()) + " bytes swapped, same hash");
+    }
+}
+
+int main()
+{
+    mt19937_64 gen(281);
+    SeededHash seeded, seeded_12345(12345), seeded_12345_again(12345), seeded_54321(54321);
+    for (size_t length : {256, 300, 512, 1000, 4096})
+    {
+        string s(length, '\0');
+        for (auto &c : s) c = (char)('a' + gen() % 26);
+        check_stripe_order("FastStringHash", FastStringHash(), s);
+        check_stripe_order("SeededHash()", seeded, s);
+        check_stripe_order("SeededHash(12345)", seeded_12345, s);
+
+        check(seeded_12345(s) == seeded_12345_again(s), "SeededHash(12345) differs between instances");
+        check(seeded_12345(s) != seeded_54321(s), "SeededHash(12345) and SeededHash(54321) agree on " +
+              to_string(length) + " bytes");
+        string flipped = s;
+        flipped[length / 2] ^= 1;
+        check(FastStringHash()(flipped) != FastStringHash()(s), "FastStringHash ignores a bit of " +
+              to_string(length) + " bytes");
+    }
+    // every length up to twice the stripe threshold, so both paths and the tail are covered
+    string s;
+    size_t previous = FastStringHash()(s);
+    for (size_t length = 1; length <= 2 * HashFunctions::STRIPE_THRESHOLD; length++)
+    {
+        s.push_back((char)('a' + gen() % 26));
+        size_t h = FastStringHash()(s);
+        check(h != previous, "FastStringHash of " + to_string(length) + " bytes equals that of its prefix");
+        previous = h;
+    }
+    return checkSummary();
+}
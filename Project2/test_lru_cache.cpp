@@ -0,0 +1,230 @@
+#include "lru_cache.hpp"
+#include "test_check.hpp"
+#include <cstdio>
+#include <list>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+using namespace std;
+
+// Checks of LruCache against a list-based model, and of ShardedLruCache from several threads
+// Build with -pthread
+
+struct string_weigh
+{
+    size_t operator()(long, const string &value) const { return value.size(); }
+};
+
+typedef LruCache<long, string, hash<long>, equal_to<long>, string_weigh> cache_type;
+
+/**
+ * The LRU policy spelled out: a list from the most to the least recently used key
+ */
+class model_cache
+{
+private:
+    list<long> order;
+    unordered_map<long, pair<string, list<long>::iterator>> entries;
+    size_t capacity, max_bytes, node_bytes, bytes = 0;
+
+    void touch(long key)
+    {
+        order.erase(entries[key].second);
+        order.push_front(key);
+        entries[key].second = order.begin();
+    }
+
+public:
+    CacheStats stats;
+
+    model_cache(size_t capacity, size_t max_bytes, size_t node_bytes)
+        : capacity(capacity), max_bytes(max_bytes), node_bytes(node_bytes) {}
+
+    bool get(long key, string &value)
+    {
+        auto it = entries.find(key);
+        if (it == entries.end())
+        {
+            stats.misses++;
+            return false;
+        }
+        stats.hits++;
+        value = it->second.first;
+        touch(key);
+        return true;
+    }
+
+    void put(long key, const string &value)
+    {
+        auto it = entries.find(key);
+        if (it == entries.end())
+        {
+            order.push_front(key);
+            entries[key] = make_pair(value, order.begin());
+        }
+        else
+        {
+            bytes -= node_bytes + it->second.first.size();
+            it->second.first = value;
+            touch(key);
+        }
+        bytes += node_bytes + value.size();
+        while ((entries.size() > capacity || (max_bytes != 0 && bytes > max_bytes)) && entries.size() > 1)
+        {
+            long victim = order.back();
+            bytes -= node_bytes + entries[victim].first.size();
+            entries.erase(victim);
+            order.pop_back();
+            stats.evictions++;
+        }
+    }
+
+    bool erase(long key)
+    {
+        auto it = entries.find(key);
+        if (it == entries.end()) return false;
+        bytes -= node_bytes + it->second.first.size();
+        order.erase(it->second.second);
+        entries.erase(it);
+        return true;
+    }
+
+    bool contains(long key) const { return entries.count(key) != 0; }
+
+    size_t size() const { return entries.size(); }
+
+    size_t get_bytes() const { return bytes; }
+};
+
+void check_against_model(size_t capacity, size_t max_bytes, long key_range, unsigned seed)
+{
+    // the bytes charged for a node besides the weigh, read from a cache holding one empty string
+    cache_type probe(1);
+    probe.put(0, string());
+    size_t node_bytes = probe.getBytes();
+
+    cache_type cache(capacity, max_bytes);
+    model_cache model(capacity, max_bytes, node_bytes);
+    mt19937_64 gen(seed);
+    string name = "LruCache(" + to_string(capacity) + ", " + to_string(max_bytes) + ")";
+    for (int op = 0; op < 200000 && checkFailures < 20; op++)
+    {
+        long key = (long)(gen() % (unsigned long)key_range);
+        string where = name + " op " + to_string(op) + " key " + to_string(key);
+        switch (gen() % 8)
+        {
+        case 0:
+        case 1:
+        case 2:
+        {
+            string got, expected;
+            bool found = cache.get(key, got);
+            check(found == model.get(key, expected), where + ": get hit differs");
+            check(!found || got == expected, where + ": get returned a wrong value");
+            break;
+        }
+        case 3:
+        case 4:
+        case 5:
+        {
+            // values of 0 to 63 bytes, so the byte bound evicts a varying number of entries
+            string value(gen() % 64, (char)('a' + key % 26));
+            value += to_string(op);
+            cache.put(key, value);
+            model.put(key, value);
+            break;
+        }
+        case 6:
+            check(cache.erase(key) == model.erase(key), where + ": erase result differs");
+            break;
+        default:
+            check(cache.contains(key) == model.contains(key), where + ": contains differs");
+        }
+        check(cache.size() == model.size(), where + ": size differs");
+        check(cache.getBytes() == model.get_bytes(), where + ": bytes differ");
+        check(cache.size() <= capacity, where + ": over capacity");
+    }
+    CacheStats stats = cache.getStats();
+    check(stats.hits == model.stats.hits && stats.misses == model.stats.misses &&
+          stats.evictions == model.stats.evictions, name + ": stats differ");
+    cache.clear();
+    check(cache.size() == 0 && cache.getBytes() == 0, name + ": not empty after clear");
+    cache.put(1, "x");
+    string value;
+    check(cache.get(1, value) && value == "x", name + ": unusable after clear");
+}
+
+/**
+ * Threads put, get and erase their own keys of a ShardedLruCache large enough to hold them all,
+ * so every result is exact, then a smaller cache is checked for its bound and for stale values
+ */
+void check_sharded()
+{
+    const size_t threads = 4, keys = 5000;
+    // twice the keys, so that no shard evicts even if the keys are not spread evenly
+    ShardedLruCache<long, long> cache(2 * threads * keys, 0, 8);
+    check(cache.getShardCount() == 8, "ShardedLruCache: shard count");
+    vector<int> thread_failures(threads, 0);
+    vector<thread> workers;
+    for (size_t t = 0; t < threads; t++)
+    {
+        workers.emplace_back([&, t]() {
+            int &bad = thread_failures[t];
+            long value = 0;
+            for (size_t i = 0; i < keys; i++)
+            {
+                long key = (long)(t + threads * i);
+                cache.put(key, key * 3);
+                bad += !cache.get(key, value) || value != key * 3;
+            }
+            for (size_t i = 0; i < keys; i += 2)
+            {
+                long key = (long)(t + threads * i);
+                bad += !cache.erase(key);
+                bad += cache.get(key, value);
+            }
+            for (size_t i = 1; i < keys; i += 2)
+            {
+                long key = (long)(t + threads * i);
+                bad += !cache.get(key, value) || value != key * 3;
+            }
+        });
+    }
+    for (auto &w : workers) w.join();
+    for (size_t t = 0; t < threads; t++)
+    {
+        check(thread_failures[t] == 0, "ShardedLruCache: thread " + to_string(t) + " saw " +
+              to_string(thread_failures[t]) + " wrong results");
+    }
+    CacheStats stats = cache.getStats();
+    check(cache.size() == threads * keys / 2, "ShardedLruCache: size after erasing half the keys");
+    check(stats.hits == threads * (keys + keys / 2) && stats.misses == threads * keys / 2 && stats.evictions == 0,
+          "ShardedLruCache: stats");
+
+    ShardedLruCache<long, long> small(100, 0, 4);
+    for (long key = 0; key < 10000; key++)
+    {
+        small.put(key % 1000, key);
+        long value = 0;
+        if (small.get(key % 1000, value)) check(value == key, "ShardedLruCache: stale value of the key just put");
+    }
+    check(small.size() <= 100, "ShardedLruCache: over capacity");
+    long value = 0;
+    for (long key = 0; key < 1000; key++)
+    {
+        if (small.get(key, value)) check(value % 1000 == key && value >= 9000, "ShardedLruCache: stale value");
+    }
+}
+
+int main()
+{
+    check_against_model(1, 0, 4, 1);
+    check_against_model(16, 0, 64, 2);
+    check_against_model(1000, 0, 1500, 3);
+    check_against_model(1000, 4096, 1500, 4);
+    check_against_model(50, 200, 100, 5);
+    check_sharded();
+    return checkSummary();
+}
@@ -0,0 +1,155 @@
+#include "hashtable.hpp"
+#include "pool_allocator.hpp"
+#include "test_check.hpp"
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+using namespace std;
+
+// Checks of NodePool, and of HashTable with PoolAllocator against unordered_map
+
+typedef HashTable<long, long, hash<long>, equal_to<long>, PrimeBucketPolicy, PoolAllocator<pair<const long, long>>>
+        pooled_table;
+
+void check_pool()
+{
+    NodePool pool;
+    const size_t n = 1000;
+    vector<void *> slots;
+    unordered_set<void *> distinct;
+    for (size_t i = 0; i < n; i++)
+    {
+        void *p = pool.allocate(24, 8);
+        slots.push_back(p);
+        distinct.insert(p);
+        check((uintptr_t)p % alignof(max_align_t) == 0, "NodePool: misaligned slot");
+        // write the whole slot, a slot shared with another would be caught by the check below
+        *(size_t *)p = i;
+        ((size_t *)p)[2] = i;
+    }
+    check(distinct.size() == n, "NodePool: a slot handed out twice");
+    check(pool.live() == n, "NodePool: live after allocating");
+    bool intact = true;
+    for (size_t i = 0; i < n; i++)
+    {
+        intact = intact && *(size_t *)slots[i] == i && ((size_t *)slots[i])[2] == i;
+    }
+    check(intact, "NodePool: slots overlap");
+    size_t reserved = pool.reserved();
+    check(reserved >= n * 24, "NodePool: reserved less than the live slots");
+
+    // freed slots are reused before any new chunk
+    for (size_t i = 0; i < n; i += 2)
+    {
+        pool.deallocate(slots[i], 24, 8);
+    }
+    check(pool.live() == n / 2, "NodePool: live after freeing half");
+    for (size_t i = 0; i < n; i += 2)
+    {
+        slots[i] = pool.allocate(24, 8);
+    }
+    check(pool.reserved() == reserved, "NodePool: freed slots not reused");
+
+    // larger or over-aligned requests bypass the pool
+    void *large = pool.allocate(4096, 8);
+    void *aligned = pool.allocate(16, 64);
+    check(pool.live() == n, "NodePool: a large or over-aligned request counted as a slot");
+    check((uintptr_t)aligned % 64 == 0, "NodePool: over-aligned request misaligned");
+    pool.deallocate(large, 4096, 8);
+    pool.deallocate(aligned, 16, 64);
+
+    pool.release();
+    check(pool.reserved() == reserved, "NodePool: release freed chunks with live slots");
+    for (void *p : slots)
+    {
+        pool.deallocate(p, 24, 8);
+    }
+    check(pool.live() == 0, "NodePool: live after freeing everything");
+    pool.release();
+    check(pool.reserved() == 0, "NodePool: chunks kept after release");
+    void *p = pool.allocate(24, 8);
+    check(pool.live() == 1 && pool.reserved() > 0, "NodePool: unusable after release");
+    pool.deallocate(p, 24, 8);
+}
+
+void check_allocator()
+{
+    // an array first must neither be pooled nor fix the slot size
+    PoolAllocator<long> allocator;
+    long *array = allocator.allocate(100);
+    check(allocator.getPool().live() == 0 && allocator.getPool().reserved() == 0, "PoolAllocator: array pooled");
+    long *single = allocator.allocate(1);
+    check(allocator.getPool().live() == 1, "PoolAllocator: single object not pooled");
+    check(allocator.getPool().reserved() < 100 * sizeof(long) * 64, "PoolAllocator: slot size fixed by an array");
+    allocator.deallocate(single, 1);
+    allocator.deallocate(array, 100);
+    check(allocator.getPool().live() == 0, "PoolAllocator: live after freeing");
+}
+
+bool same(pooled_table &table, const unordered_map<long, long> &expected)
+{
+    if (table.size() != expected.size()) return false;
+    for (auto &kv : expected)
+    {
+        auto it = table.find(kv.first);
+        if (it == table.end() || it->second != kv.second) return false;
+    }
+    return true;
+}
+
+void check_table()
+{
+    mt19937_64 gen(281);
+    pooled_table table;
+    unordered_map<long, long> expected;
+    for (int op = 0; op < 200000; op++)
+    {
+        long key = (long)(gen() % 20000);
+        if (gen() % 3 == 0)
+        {
+            check(table.erase(key) == (expected.erase(key) != 0), "HashTable: erase result differs");
+        }
+        else
+        {
+            table[key] = op;
+            expected[key] = op;
+        }
+    }
+    check(same(table, expected), "HashTable: contents differ from unordered_map");
+    // one slot per node, the bucket array is not pooled
+    check(table.getAllocator().getPool().live() == table.size(), "HashTable: live slots differ from the size");
+
+    // a copy gets its own pool, and is independent of the original
+    pooled_table copy(table);
+    check(copy.getAllocator() != table.getAllocator(), "HashTable copy: shares the pool of the original");
+    check(same(copy, expected), "HashTable copy: contents differ");
+    check(copy.getAllocator().getPool().live() == copy.size(), "HashTable copy: live slots differ from the size");
+    copy.clear();
+    check(same(table, expected), "HashTable: changed by clearing its copy");
+
+    // a move keeps the pool
+    PoolAllocator<pair<const long, long>> allocator = table.getAllocator();
+    pooled_table moved(std::move(table));
+    check(moved.getAllocator() == allocator, "HashTable move: pool not kept");
+    check(same(moved, expected), "HashTable move: contents differ");
+    check(allocator.getPool().live() == moved.size(), "HashTable move: live slots differ from the size");
+
+    moved.clear();
+    check(allocator.getPool().live() == 0, "HashTable clear: slots still live");
+    check(allocator.getPool().reserved() == 0, "HashTable clear: chunks not released");
+    moved.insert(1, 2);
+    check(moved.size() == 1 && moved.find(1)->second == 2, "HashTable: unusable after clear");
+}
+
+int main()
+{
+    check_pool();
+    check_allocator();
+    check_table();
+    return checkSummary();
+}
@@ -0,0 +1,109 @@
+#include "sharded_aggregator.hpp"
+#include "test_check.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+using namespace std;
+
+// Checks of ShardedAggregator: every thread aggregates its own slice of the input into its shard,
+// the merged table must equal a single-threaded aggregation of the whole input
+// Build with -pthread
+
+struct max_reduce
+{
+    long operator()(long a, long b) const { return max(a, b); }
+};
+
+/**
+ * Aggregate (keys[i], values[i]) with aggregator, thread t adding the elements i = t mod threads,
+ * then compare the merge with expected
+ */
+template <typename Aggregator, typename Key, typename Reduce>
+void check_merge(const string &name, Aggregator &aggregator, const vector<Key> &keys, const vector<long> &values,
+                 Reduce reduce, unsigned merge_threads)
+{
+    unordered_map<Key, long> expected;
+    for (size_t i = 0; i < keys.size(); i++)
+    {
+        auto it = expected.find(keys[i]);
+        if (it == expected.end()) expected.emplace(keys[i], values[i]);
+        else it->second = reduce(it->second, values[i]);
+    }
+    unsigned threads = aggregator.getThreadCount();
+    vector<thread> workers;
+    for (unsigned t = 0; t < threads; t++)
+    {
+        workers.emplace_back([&, t]() {
+            auto &shard = aggregator.shard(t);
+            for (size_t i = t; i < keys.size(); i += threads)
+            {
+                shard.add(keys[i], values[i]);
+            }
+        });
+    }
+    for (auto &w : workers) w.join();
+
+    auto table = aggregator.merge(merge_threads);
+    check(table.size() == expected.size(), name + ": merged " + to_string(table.size()) + " keys, expected " +
+          to_string(expected.size()));
+    size_t wrong = 0;
+    for (auto &kv : expected)
+    {
+        auto it = table.find(kv.first);
+        wrong += it == table.end() || it->second != kv.second;
+    }
+    check(wrong == 0, name + ": " + to_string(wrong) + " keys missing or with a wrong value");
+    for (unsigned t = 0; t < threads; t++)
+    {
+        check(aggregator.shard(t).size() == 0, name + ": shard " + to_string(t) + " not empty after merge");
+    }
+}
+
+int main()
+{
+    mt19937_64 gen(281);
+    const size_t n = 200000;
+    // Zipf-like keys: many repeats of few keys, and a long tail seen once
+    vector<long> keys(n), values(n);
+    for (size_t i = 0; i < n; i++)
+    {
+        keys[i] = (long)(gen() % (1 + gen() % 50000));
+        values[i] = (long)(gen() % 1000) - 500;
+    }
+
+    ShardedAggregator<long, long> sums(4);
+    check(sums.getPartitionCount() == 16, "4 threads get 16 partitions");
+    check_merge("sum, 4 threads", sums, keys, values, plus<long>(), 4);
+    // the shards are left empty, so the aggregator can be filled and merged again
+    check_merge("sum, reused", sums, keys, values, plus<long>(), 3);
+
+    ShardedAggregator<long, long, max_reduce> maxima(3, 1);
+    check(maxima.getPartitionCount() == 2, "partitionBits = 1 gives 2 partitions");
+    check_merge("max, 3 threads, 2 partitions", maxima, keys, values, max_reduce(), 8);
+
+    ShardedAggregator<long, long> single(1);
+    check_merge("sum, 1 thread", single, keys, values, plus<long>(), 1);
+
+    vector<string> words(n / 4);
+    vector<long> ones(n / 4, 1);
+    for (auto &w : words)
+    {
+        w = "word" + to_string(gen() % 3000);
+    }
+    ShardedAggregator<string, long> counts(5);
+    check_merge("string counts, 5 threads", counts, words, ones, plus<long>(), 2);
+
+    // operator[] of a shard, as used for counting
+    ShardedAggregator<long, long> counter(2);
+    counter.shard(0)[7]++;
+    counter.shard(1)[7] += 2;
+    counter.shard(1)[8]++;
+    auto table = counter.merge(2);
+    check(table.size() == 2 && table[7] == 3 && table[8] == 1, "counts through operator[]");
+
+    return checkSummary();
+}
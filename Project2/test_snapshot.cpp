@@ -0,0 +1,196 @@
+#include "hashtable.hpp"
+#include "snapshot.hpp"
+#include "test_check.hpp"
+#include <cstddef>
+#include <cstdio>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+using namespace std;
+
+// Usage: ./test_snapshot [directory=/tmp]
+// Checks of SnapshotBuilder and MappedHashTable: snapshots are written to the directory, mapped back and
+// compared with what was added, then corrupted on purpose to check that loading rejects them
+
+/**
+ * @return whether mapping path throws a runtime_error whose message contains reason
+ */
+template <typename Key, typename Value>
+bool rejected(const string &path, bool verify, const string &reason)
+{
+    try
+    {
+        MappedHashTable<Key, Value> table(path, verify);
+    }
+    catch (const runtime_error &e)
+    {
+        return string(e.what()).find(reason) != string::npos;
+    }
+    return false;
+}
+
+/**
+ * Overwrite size bytes at offset of a file
+ */
+void patch(const string &path, long offset, const void *data, size_t size)
+{
+    FILE *file = fopen(path.c_str(), "r+b");
+    if (file == nullptr) throw runtime_error("cannot open " + path);
+    fseek(file, offset, SEEK_SET);
+    fwrite(data, 1, size, file);
+    fclose(file);
+}
+
+void check_long_snapshot(const string &path)
+{
+    const size_t n = 100000;
+    mt19937_64 gen(281);
+    SnapshotBuilder<long, long> builder(1.0);
+    unordered_map<long, long> expected;
+    // about a third of the keys are added more than once, the last value must win
+    for (size_t i = 0; i < n; i++)
+    {
+        long key = (long)(gen() % n);
+        builder.add(key, (long)i);
+        expected[key] = (long)i;
+    }
+    builder.write(path);
+
+    {
+        MappedHashTable<long, long> table(path);
+        check(table.size() == expected.size(), "long snapshot: duplicates kept");
+        check(table.bucketSize() == expected.size(), "long snapshot: bucket count not sized by the distinct keys");
+        size_t wrong = 0;
+        for (auto &kv : expected)
+        {
+            const long *value = table.find(kv.first);
+            wrong += value == nullptr || *value != kv.second;
+        }
+        check(wrong == 0, "long snapshot: " + to_string(wrong) + " keys missing or with a wrong value");
+        size_t found = 0;
+        for (long key = (long)n; key < (long)n + 10000; key++)
+        {
+            found += table.contains(key);
+        }
+        check(found == 0, "long snapshot: keys never added found");
+        size_t iterated = 0;
+        for (auto it = table.begin(); it != table.end(); ++it)
+        {
+            auto kv = expected.find(it->key);
+            iterated += kv != expected.end() && kv->second == it->value;
+        }
+        check(iterated == expected.size(), "long snapshot: iteration differs");
+    }
+
+    check(rejected<int, long>(path, true, "another key or value type"), "long snapshot: mapped with another key type");
+
+    // a changed value, here of the last entry, passes the layout checks, only the checksum catches it
+    long value = -1;
+    FILE *file = fopen(path.c_str(), "rb");
+    fseek(file, 0, SEEK_END);
+    long fileSize = ftell(file);
+    fclose(file);
+    patch(path, fileSize - (long)sizeof(long), &value, sizeof(value));
+    check(rejected<long, long>(path, true, "checksum mismatch"), "long snapshot: changed value not detected");
+
+    // so does a changed bucket count, since the checksum covers the header
+    builder.write(path);
+    uint64_t bucketCount = expected.size() - 1;
+    patch(path, (long)offsetof(SnapshotHeader, bucketCount), &bucketCount, sizeof(bucketCount));
+    check(rejected<long, long>(path, true, "checksum mismatch"), "long snapshot: changed bucket count not detected");
+    check(!rejected<long, long>(path, false, ""), "long snapshot: rejected without verification");
+
+    // a truncated file fails the layout checks even without verification
+    builder.write(path);
+    vector<char> bytes(sizeof(SnapshotHeader) + 100);
+    file = fopen(path.c_str(), "rb");
+    size_t got = fread(bytes.data(), 1, bytes.size(), file);
+    fclose(file);
+    file = fopen(path.c_str(), "wb");
+    fwrite(bytes.data(), 1, got, file);
+    fclose(file);
+    check(rejected<long, long>(path, false, "truncated or corrupted"), "long snapshot: truncation not detected");
+}
+
+void check_small_snapshots(const string &path)
+{
+    SnapshotBuilder<long, long> empty;
+    empty.write(path);
+    {
+        MappedHashTable<long, long> table(path);
+        check(table.size() == 0 && table.bucketSize() >= 1, "empty snapshot: size");
+        check(!table.contains(3) && table.begin() == table.end(), "empty snapshot: not empty");
+    }
+
+    // an entry with padding, and a load factor below 1
+    SnapshotBuilder<int, char> builder(0.3);
+    for (int i = 0; i < 1000; i++)
+    {
+        builder.add(i % 700, (char)i);
+    }
+    builder.write(path);
+    {
+        MappedHashTable<int, char> table(path);
+        check(table.size() == 700 && table.bucketSize() == 2333, "int snapshot: size or bucket count");
+        bool correct = true;
+        for (int i = 0; i < 700; i++)
+        {
+            const char *value = table.find(i);
+            correct = correct && value != nullptr && *value == (char)(i < 300 ? i + 700 : i);
+        }
+        check(correct, "int snapshot: wrong values");
+        check(!table.contains(700) && !table.contains(-1), "int snapshot: keys never added found");
+    }
+
+    // from a HashTable
+    HashTable<long, long> source;
+    for (long key = 0; key < 5000; key++)
+    {
+        source.insert(key * 7, key);
+    }
+    SnapshotBuilder<long, long> fromTable(0.5);
+    fromTable.addAll(source);
+    fromTable.write(path);
+    {
+        MappedHashTable<long, long> table(path);
+        bool correct = table.size() == 5000;
+        for (long key = 0; key < 5000 && correct; key++)
+        {
+            const long *value = table.find(key * 7);
+            correct = value != nullptr && *value == key && !table.contains(key * 7 + 1);
+        }
+        check(correct, "snapshot of a HashTable differs from it");
+    }
+
+    check(!rejected<long, long>(path, true, ""), "snapshot rejected");
+    check(rejected<long, long>(path + ".missing", true, "cannot open"), "missing file mapped");
+    check(SnapshotBuilder<long, long>().size() == 0, "new builder not empty");
+    bool thrown = false;
+    try
+    {
+        SnapshotBuilder<long, long> invalid(0.0);
+    }
+    catch (const range_error &)
+    {
+        thrown = true;
+    }
+    check(thrown, "a load factor of 0 accepted");
+}
+
+int main(int argc, char *argv[])
+{
+    string path = string(argc > 1 ? argv[1] : "/tmp") + "/test_snapshot.snap";
+    try
+    {
+        check_long_snapshot(path);
+        check_small_snapshots(path);
+    }
+    catch (const exception &e)
+    {
+        check(false, e.what());
+    }
+    remove(path.c_str());
+    return checkSummary();
+}
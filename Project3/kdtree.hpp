@@ -5,6 +5,40 @@
 #include <stdexcept>
 #include <iostream>
 #include <string>
+#include <array>
+#include <cmath>
+#include <utility>
+
+/**
+ * Distance metrics for KDTree::kNearest, on keys of arithmetic types
+ * A metric accumulates a term per dimension with combine, and finish turns the accumulated value into the distance
+ * The search compares accumulated values only, and prunes a subtree when the terms of the splitting planes
+ * bounding it, combined, are not smaller than the accumulated value of the k-th nearest key found
+ */
+struct EuclideanMetric {    // L2, accumulated as the squared distance
+    static double term(double diff) { return diff * diff; }
+
+    static double combine(double sum, double term) { return sum + term; }
+
+    static double finish(double sum) { return std::sqrt(sum); }
+};
+
+struct ManhattanMetric {    // L1
+    static double term(double diff) { return std::fabs(diff); }
+
+    static double combine(double sum, double term) { return sum + term; }
+
+    static double finish(double sum) { return sum; }
+};
+
+struct ChebyshevMetric {    // L-infinity
+    static double term(double diff) { return std::fabs(diff); }
+
+    static double combine(double max, double term) { return std::max(max, term); }
+
+    static double finish(double max) { return max; }
+};
+
 /**
  * An abstract template base of the KDTree class
  */
@@ -545,6 +579,70 @@ protected:                      // DO NOT USE private HERE!
         delete thisNode;
     }
 
+    typedef std::pair<double, Node*> Neighbor;  // accumulated distance to the query, node
+
+    static bool closerNeighbor(const Neighbor& a, const Neighbor& b) {
+        return a.first < b.first;
+    }
+
+    template<typename Metric, size_t... DIMS>
+    static double accumulatedDistance(const Key& a, const Key& b, std::index_sequence<DIMS...>) {
+        double sum = 0;
+        ((sum = Metric::combine(sum, Metric::term(static_cast<double>(std::get<DIMS>(a)) -
+                                                  static_cast<double>(std::get<DIMS>(b))))), ...);
+        return sum;
+    }
+
+    /**
+     * Search the subtree of node for the count nearest keys to query
+     * Time Complexity: O(k + log count) per visited node
+     * @tparam Metric
+     * @tparam DIM current dimension of node
+     * @param node
+     * @param query
+     * @param count
+     * @param heap max-heap of the (at most count) nearest nodes found, by accumulated distance
+     * @param planeTerms per dimension, the term of the nearest splitting plane between query and the subtree
+     *                   (0 if query is on the side of the subtree of every plane of that dimension)
+     */
+    template<typename Metric, size_t DIM>
+    static void kNearestHelper(Node* node, const Key& query, size_t count, std::vector<Neighbor>& heap,
+                               std::array<double, KeySize>& planeTerms) {
+        constexpr size_t DIM_NEXT = (DIM + 1) % KeySize;
+        if (!node) {
+            return;
+        }
+        double distance = accumulatedDistance<Metric>(query, node->key(), std::make_index_sequence<KeySize>());
+        if (heap.size() < count) {
+            heap.emplace_back(distance, node);
+            std::push_heap(heap.begin(), heap.end(), closerNeighbor);
+        }
+        else if (distance < heap.front().first) {
+            std::pop_heap(heap.begin(), heap.end(), closerNeighbor);
+            heap.back() = Neighbor(distance, node);
+            std::push_heap(heap.begin(), heap.end(), closerNeighbor);
+        }
+        // keys of the left subtree are not greater than node on DIM, those of the right subtree not less
+        double diff = static_cast<double>(std::get<DIM>(query)) - static_cast<double>(std::get<DIM>(node->key()));
+        Node* nearSubTree = diff < 0 ? node->left : node->right;
+        Node* farSubTree = diff < 0 ? node->right : node->left;
+        kNearestHelper<Metric, DIM_NEXT>(nearSubTree, query, count, heap, planeTerms);
+        if (!farSubTree) {
+            return;
+        }
+        // every key of the far subtree is beyond this plane, and those bounding node's subtree on other dimensions
+        double nodePlaneTerm = planeTerms[DIM];
+        planeTerms[DIM] = Metric::term(diff);
+        double farDistance = 0;
+        for (double term: planeTerms) {
+            farDistance = Metric::combine(farDistance, term);
+        }
+        if (heap.size() < count || farDistance < heap.front().first) {
+            kNearestHelper<Metric, DIM_NEXT>(farSubTree, query, count, heap, planeTerms);
+        }
+        planeTerms[DIM] = nodePlaneTerm;
+    }
+
     template<size_t DIM>
     static bool compareAllKeysHelper(const Data& a, const Data& b){
         constexpr size_t DIM_NEXT = (DIM + 1) % KeySize;
@@ -589,9 +687,10 @@ public:
 //        for (auto &item: v) {
 //            std::cout << "Constr " << std::get<0>(item.first) << " " << std::get<1>(item.first) << " " << std::get<2>(item.first) << " Val: " << item.second << std::endl;
 //        }
-        std::stable_sort(v.begin(), v.end(), compareAllKeysHelper<0>);
-        auto eraseIt = std::unique(v.rbegin(), v.rend());
-        v.erase(v.begin(), ++eraseIt.base());
+        // keep the last value of each key, as inserting them in turn would
+        std::stable_sort(v.begin(), v.end(), [](const auto &a, const auto &b){ return a.first < b.first; });
+        auto eraseIt = std::unique(v.rbegin(), v.rend(), [](const auto &a, const auto &b){ return a.first == b.first; });
+        v.erase(v.begin(), eraseIt.base());
         root = constructHelper<0>(nullptr, v.begin(), v.end());
         treeSize = v.size();
     }
@@ -662,6 +761,56 @@ public:
         return Iterator(this, findMaxDynamic<0>(dim));
     }
 
+    /**
+     * Find the count nearest keys to query (all the keys if there are fewer than count)
+     * The subtree nearer to query is searched first, and the other one only if the splitting planes
+     * between query and it are nearer than the count-th nearest key found so far
+     * Time Complexity: O(n (k + log count)) in the worst case, close to O(count log n) for few dimensions
+     * @tparam Metric EuclideanMetric (L2), ManhattanMetric (L1) or ChebyshevMetric (L-infinity)
+     * @param query
+     * @param count number of keys to find
+     * @return iterators of the nearest keys, the nearest first
+     */
+    template<typename Metric = EuclideanMetric>
+    std::vector<Iterator> kNearest(const Key& query, size_t count) {
+        if (count == 0) {
+            return {};
+        }
+        std::vector<Neighbor> heap;
+        heap.reserve(std::min(count, treeSize));
+        std::array<double, KeySize> planeTerms{};
+        kNearestHelper<Metric, 0>(root, query, count, heap, planeTerms);
+        std::sort_heap(heap.begin(), heap.end(), closerNeighbor);
+        std::vector<Iterator> result;
+        result.reserve(heap.size());
+        for (auto &neighbor: heap) {
+            result.push_back(Iterator(this, neighbor.second));
+        }
+        return result;
+    }
+
+    /**
+     * Find the nearest key to query
+     * Time Complexity: O(kn) in the worst case, close to O(log n) for few dimensions
+     * @tparam Metric EuclideanMetric (L2), ManhattanMetric (L1) or ChebyshevMetric (L-infinity)
+     * @param query
+     * @return iterator of the nearest key, or end() if the tree is empty
+     */
+    template<typename Metric = EuclideanMetric>
+    Iterator nearest(const Key& query) {
+        auto result = kNearest<Metric>(query, 1);
+        return result.empty() ? end() : result.front();
+    }
+
+    /**
+     * Time Complexity: O(k)
+     * @return the distance between two keys under Metric
+     */
+    template<typename Metric = EuclideanMetric>
+    static double distance(const Key& a, const Key& b) {
+        return Metric::finish(accumulatedDistance<Metric>(a, b, std::make_index_sequence<KeySize>()));
+    }
+
     bool erase(const Key& key) {
         //std::cout << "Erase "  << std::get<0>(key) << " " << std::get<1>(key) << " " << std::get<2>(key);
         auto prevSize = treeSize;
@@ -0,0 +1,143 @@
+#include "kdtree.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <tuple>
+#include <utility>
+#include <vector>
+using namespace std;
+
+// Usage: ./kdtree_performance [max_exponent=5] [queries=1000] [seed]
+// For n from 10^3 to 10^max_exponent uniformly random points of 2, 3, 5 and 8 double coordinates,
+// the k = 1, 10 and 100 nearest points of random queries are found with KDTree::kNearest and by brute force
+// (a linear scan keeping the k nearest), under the L2, L1 and L-infinity metrics, and the distances are checked to agree
+// Output (CSV): metric,dimensions,n,k,kdtree,brute_force,speedup
+// (microseconds per query)
+
+template <size_t... I>
+auto make_point_type(index_sequence<I...>) -> tuple<decltype((void)I, 0.0)...>;
+
+template <size_t D>
+using point = decltype(make_point_type(make_index_sequence<D>()));
+
+template <size_t D, size_t... I>
+point<D> random_point(mt19937_64 &gen, index_sequence<I...>)
+{
+    uniform_real_distribution<double> coordinate(0, 1);
+    return point<D>(((void)I, coordinate(gen))...);
+}
+
+double us_since(chrono::steady_clock::time_point start, size_t ops)
+{
+    chrono::duration<double, micro> elapsed = chrono::steady_clock::now() - start;
+    return elapsed.count() / (double)ops;
+}
+
+template <typename Metric, size_t D>
+vector<double> brute_force(const vector<pair<point<D>, int>> &points, const point<D> &query, size_t k)
+{
+    typedef KDTree<point<D>, int> tree;
+    vector<double> heap;
+    for (auto &p : points)
+    {
+        double distance = tree::template distance<Metric>(query, p.first);
+        if (heap.size() < k)
+        {
+            heap.push_back(distance);
+            push_heap(heap.begin(), heap.end());
+        }
+        else if (distance < heap.front())
+        {
+            pop_heap(heap.begin(), heap.end());
+            heap.back() = distance;
+            push_heap(heap.begin(), heap.end());
+        }
+    }
+    sort_heap(heap.begin(), heap.end());
+    return heap;
+}
+
+template <typename Metric, size_t D>
+void run(const char *metric, size_t n, size_t k, size_t queries, mt19937_64 &gen)
+{
+    vector<pair<point<D>, int>> points(n), query_points(queries);
+    for (size_t i = 0; i < n; i++)
+    {
+        points[i] = make_pair(random_point<D>(gen, make_index_sequence<D>()), (int)i);
+    }
+    for (auto &q : query_points)
+    {
+        q.first = random_point<D>(gen, make_index_sequence<D>());
+    }
+    KDTree<point<D>, int> tree(points);
+
+    vector<vector<double>> expected(queries);
+    auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i < queries; i++)
+    {
+        expected[i] = brute_force<Metric, D>(points, query_points[i].first, k);
+    }
+    double brute_force_time = us_since(start, queries);
+
+    vector<vector<typename KDTree<point<D>, int>::Iterator>> found(queries);
+    start = chrono::steady_clock::now();
+    for (size_t i = 0; i < queries; i++)
+    {
+        found[i] = tree.template kNearest<Metric>(query_points[i].first, k);
+    }
+    double kdtree_time = us_since(start, queries);
+
+    for (size_t i = 0; i < queries; i++)
+    {
+        bool same = found[i].size() == expected[i].size();
+        for (size_t j = 0; same && j < found[i].size(); j++)
+        {
+            same = KDTree<point<D>, int>::template distance<Metric>(query_points[i].first, found[i][j]->first) == expected[i][j];
+        }
+        if (!same)
+        {
+            fprintf(stderr, "%s d=%zu n=%zu k=%zu: kNearest differs from brute force\n", metric, D, n, k);
+            exit(1);
+        }
+    }
+    printf("%s,%zu,%zu,%zu,%.3f,%.3f,%.1f\n", metric, D, n, k, kdtree_time, brute_force_time,
+           brute_force_time / kdtree_time);
+    fflush(stdout);
+}
+
+template <typename Metric, size_t D>
+void run_all(const char *metric, int max_exponent, size_t queries, mt19937_64 &gen)
+{
+    size_t n = 100;
+    for (int e = 3; e <= max_exponent; e++)
+    {
+        n *= 10;
+        for (size_t k : {1, 10, 100})
+        {
+            run<Metric, D>(metric, n, k, queries, gen);
+        }
+    }
+}
+
+template <typename Metric>
+void run_dimensions(const char *metric, int max_exponent, size_t queries, mt19937_64 &gen)
+{
+    run_all<Metric, 2>(metric, max_exponent, queries, gen);
+    run_all<Metric, 3>(metric, max_exponent, queries, gen);
+    run_all<Metric, 5>(metric, max_exponent, queries, gen);
+    run_all<Metric, 8>(metric, max_exponent, queries, gen);
+}
+
+int main(int argc, char *argv[])
+{
+    int max_exponent = argc > 1 ? atoi(argv[1]) : 5;
+    size_t queries = argc > 2 ? strtoul(argv[2], nullptr, 10) : 1000;
+    unsigned long seed = argc > 3 ? strtoul(argv[3], nullptr, 10) : 281;
+    mt19937_64 gen(seed);
+    printf("metric,dimensions,n,k,kdtree,brute_force,speedup\n");
+    run_dimensions<EuclideanMetric>("L2", max_exponent, queries, gen);
+    run_dimensions<ManhattanMetric>("L1", max_exponent, queries, gen);
+    run_dimensions<ChebyshevMetric>("Linf", max_exponent, queries, gen);
+    return 0;
+}